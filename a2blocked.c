@@ -1,6 +1,7 @@
 #include <string.h>
 
-#include <a2blocked.h>
+#include "a2blocked.h"
+#include "a2hilbert.h"
 #include "uarray2b.h"
 
 // define a private version of each function in A2Methods_T that we implement
@@ -17,6 +18,49 @@ static A2 new_with_blocksize(int width, int height, int size, int blocksize)
         return UArray2b_new(width, height, size, blocksize);
 }
 
+static A2 new_pow2(int width, int height, int size)
+{
+        return UArray2b_new_64K_pow2_block(width, height, size);
+}
+
+static A2 new_with_blocksize_pow2(int width, int height, int size,
+                                  int blocksize)
+{
+        int pow2 = 1;
+        while (2 * pow2 <= blocksize)
+                pow2 *= 2;
+        return UArray2b_new(width, height, size, pow2);
+}
+
+static A2 new_cache(int width, int height, int size)
+{
+        return UArray2b_new_cache_block(width, height, size);
+}
+
+static A2 new_line(int width, int height, int size)
+{
+        return UArray2b_new_64K_line_block(width, height, size);
+}
+
+static A2 new_with_block_shape(int width, int height, int size,
+                               int block_width, int block_height)
+{
+        return UArray2b_new_rect(width, height, size, block_width,
+                                 block_height);
+}
+
+static A2 new_with_block_shape_pow2(int width, int height, int size,
+                                    int block_width, int block_height)
+{
+        int pow2_width = 1, pow2_height = 1;
+        while (2 * pow2_width <= block_width)
+                pow2_width *= 2;
+        while (2 * pow2_height <= block_height)
+                pow2_height *= 2;
+        return UArray2b_new_rect(width, height, size, pow2_width,
+                                 pow2_height);
+}
+
 static void a2free(A2 * array2p)
 {
         UArray2b_free((UArray2b_T *) array2p);
@@ -44,6 +88,11 @@ static A2Methods_Object *at(A2 array2, int i, int j)
         return UArray2b_at(array2, i, j);
 }
 
+static A2Methods_Object *at_pow2(A2 array2, int i, int j)
+{
+        return UArray2b_at_pow2(array2, i, j);
+}
+
 typedef void applyfun(int i, int j, UArray2b_T array2b, void *elem, void *cl);
 
 static void map_block_major(A2 array2, A2Methods_applyfun apply, void *cl)
@@ -51,6 +100,33 @@ static void map_block_major(A2 array2, A2Methods_applyfun apply, void *cl)
         UArray2b_map(array2, (applyfun *) apply, cl);
 }
 
+typedef void blockfun(int col, int row, int width, int height, void *base,
+                      int stride, void *cl);
+
+static void map_blocks(A2 array2, A2Methods_blockfun apply, void *cl)
+{
+        UArray2b_map_blocks(array2, (blockfun *) apply, cl);
+}
+
+typedef void spanfun(int col, int row, int length, void *first, int stride,
+                     void *cl);
+
+static void map_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+        UArray2b_map_spans(array2, (spanfun *) apply, cl);
+}
+
+static void map_hilbert(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        A2Hilbert_map(array2, width(array2), height(array2), at, apply, cl);
+}
+
+static void map_hilbert_pow2(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        A2Hilbert_map(array2, width(array2), height(array2), at_pow2, apply,
+                      cl);
+}
+
 struct small_closure {
         A2Methods_smallapplyfun *apply;
         void *cl;
@@ -72,6 +148,19 @@ static void small_map_block_major(A2 a2, A2Methods_smallapplyfun apply,
         UArray2b_map(a2, apply_small, &mycl);
 }
 
+static void small_map_hilbert(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        map_hilbert(a2, (A2Methods_applyfun *) apply_small, &mycl);
+}
+
+static void small_map_hilbert_pow2(A2 a2, A2Methods_smallapplyfun apply,
+                                   void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        map_hilbert_pow2(a2, (A2Methods_applyfun *) apply_small, &mycl);
+}
+
 static struct A2Methods_T uarray2_methods_blocked_struct = {
         new,
         new_with_blocksize,
@@ -89,8 +178,99 @@ static struct A2Methods_T uarray2_methods_blocked_struct = {
         NULL,                   // small_map_col_major
         small_map_block_major,
         small_map_block_major,  // small_map_default
+        map_hilbert,
+        small_map_hilbert,
+        map_blocks,
+        new_with_block_shape,
+        map_spans,
+};
+
+static struct A2Methods_T uarray2_methods_blocked_pow2_struct = {
+        new_pow2,
+        new_with_blocksize_pow2,
+        a2free,
+        width,
+        height,
+        size,
+        blocksize,
+        at_pow2,
+        NULL,                   // map_row_major
+        NULL,                   // map_col_major
+        map_block_major,
+        map_block_major,        // map_default
+        NULL,                   // small_map_row_major
+        NULL,                   // small_map_col_major
+        small_map_block_major,
+        small_map_block_major,  // small_map_default
+        map_hilbert_pow2,
+        small_map_hilbert_pow2,
+        map_blocks,
+        new_with_block_shape_pow2,
+        map_spans,
+};
+
+static struct A2Methods_T uarray2_methods_blocked_cache_struct = {
+        new_cache,
+        new_with_blocksize,
+        a2free,
+        width,
+        height,
+        size,
+        blocksize,
+        at,
+        NULL,                   // map_row_major
+        NULL,                   // map_col_major
+        map_block_major,
+        map_block_major,        // map_default
+        NULL,                   // small_map_row_major
+        NULL,                   // small_map_col_major
+        small_map_block_major,
+        small_map_block_major,  // small_map_default
+        map_hilbert,
+        small_map_hilbert,
+        map_blocks,
+        new_with_block_shape,
+        map_spans,
+};
+
+static struct A2Methods_T uarray2_methods_blocked_line_struct = {
+        new_line,
+        new_with_blocksize,
+        a2free,
+        width,
+        height,
+        size,
+        blocksize,
+        at,
+        NULL,                   // map_row_major
+        NULL,                   // map_col_major
+        map_block_major,
+        map_block_major,        // map_default
+        NULL,                   // small_map_row_major
+        NULL,                   // small_map_col_major
+        small_map_block_major,
+        small_map_block_major,  // small_map_default
+        map_hilbert,
+        small_map_hilbert,
+        map_blocks,
+        new_with_block_shape,
+        map_spans,
 };
 
 // finally the payoff: here is the exported pointer to the struct
 
 A2Methods_T uarray2_methods_blocked = &uarray2_methods_blocked_struct;
+A2Methods_T uarray2_methods_blocked_pow2 =
+        &uarray2_methods_blocked_pow2_struct;
+A2Methods_T uarray2_methods_blocked_cache =
+        &uarray2_methods_blocked_cache_struct;
+A2Methods_T uarray2_methods_blocked_line =
+        &uarray2_methods_blocked_line_struct;
+
+int A2Blocked_is_blocked(const struct A2Methods_T *methods)
+{
+        return methods == uarray2_methods_blocked
+            || methods == uarray2_methods_blocked_pow2
+            || methods == uarray2_methods_blocked_cache
+            || methods == uarray2_methods_blocked_line;
+}
@@ -0,0 +1,23 @@
+#ifndef A2BLOCKED_INCLUDED
+#define A2BLOCKED_INCLUDED
+#include "a2methods.h"
+
+extern A2Methods_T uarray2_methods_blocked;
+
+// same as uarray2_methods_blocked, but blocksizes are rounded down
+// to a power of two so that 'at' never divides
+extern A2Methods_T uarray2_methods_blocked_pow2;
+
+// same as uarray2_methods_blocked, but 'new' sizes blocks for this
+// machine's caches (see cacheinfo.h)
+extern A2Methods_T uarray2_methods_blocked_cache;
+
+// same as uarray2_methods_blocked, but 'new' makes ~64KB blocks whose
+// rows are a whole number of cache lines
+extern A2Methods_T uarray2_methods_blocked_line;
+
+// true if 'methods' is one of the suites above, whose arrays are all
+// UArray2b_T; a new blocked suite must be added here
+extern int A2Blocked_is_blocked(const struct A2Methods_T *methods);
+
+#endif
@@ -0,0 +1,135 @@
+#include <string.h>
+
+#include "a2hier.h"
+#include "a2hilbert.h"
+#include "uarray2h.h"
+
+// define a private version of each function in A2Methods_T that we implement
+
+typedef A2Methods_UArray2 A2;   // private abbreviation
+
+static A2 new(int width, int height, int size)
+{
+        return UArray2h_new_default(width, height, size);
+}
+
+// the blocksize is rounded down to a power of two; tiles keep their
+// default size but are split at least 2 x 2 per block
+static A2 new_with_blocksize(int width, int height, int size, int blocksize)
+{
+        int outer = 1;
+        while (2 * outer <= blocksize)
+                outer *= 2;
+        int inner = UArray2h_default_tilesize(size);
+        while (inner > 1 && inner > outer / 2)
+                inner /= 2;
+        return UArray2h_new(width, height, size, outer, inner);
+}
+
+static void a2free(A2 * array2p)
+{
+        UArray2h_free((UArray2h_T *) array2p);
+}
+
+static int width(A2 array2)
+{
+        return UArray2h_width(array2);
+}
+static int height(A2 array2)
+{
+        return UArray2h_height(array2);
+}
+static int size(A2 array2)
+{
+        return UArray2h_size(array2);
+}
+static int blocksize(A2 array2)
+{
+        return UArray2h_blocksize(array2);
+}
+
+static A2Methods_Object *at(A2 array2, int i, int j)
+{
+        return UArray2h_at(array2, i, j);
+}
+
+typedef void applyfun(int i, int j, UArray2h_T array2h, void *elem, void *cl);
+typedef void blockfun(int col, int row, int width, int height, void *base,
+                      int stride, void *cl);
+
+static void map_block_major(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        UArray2h_map(array2, (applyfun *) apply, cl);
+}
+
+static void map_tiles(A2 array2, A2Methods_blockfun apply, void *cl)
+{
+        UArray2h_map_tiles(array2, (blockfun *) apply, cl);
+}
+
+typedef void spanfun(int col, int row, int length, void *first, int stride,
+                     void *cl);
+
+static void map_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+        UArray2h_map_spans(array2, (spanfun *) apply, cl);
+}
+
+static void map_hilbert(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        A2Hilbert_map(array2, width(array2), height(array2), at, apply, cl);
+}
+
+struct small_closure {
+        A2Methods_smallapplyfun *apply;
+        void *cl;
+};
+
+static void apply_small(int i, int j, UArray2h_T array2, void *elem, void *vcl)
+{
+        struct small_closure *cl = vcl;
+        (void)i;
+        (void)j;
+        (void)array2;
+        cl->apply(elem, cl->cl);
+}
+
+static void small_map_block_major(A2 a2, A2Methods_smallapplyfun apply,
+                                  void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        UArray2h_map(a2, apply_small, &mycl);
+}
+
+static void small_map_hilbert(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        map_hilbert(a2, (A2Methods_applyfun *) apply_small, &mycl);
+}
+
+static struct A2Methods_T uarray2_methods_hierarchical_struct = {
+        new,
+        new_with_blocksize,
+        a2free,
+        width,
+        height,
+        size,
+        blocksize,
+        at,
+        NULL,                   // map_row_major
+        NULL,                   // map_col_major
+        map_block_major,
+        map_block_major,        // map_default
+        NULL,                   // small_map_row_major
+        NULL,                   // small_map_col_major
+        small_map_block_major,
+        small_map_block_major,  // small_map_default
+        map_hilbert,
+        small_map_hilbert,
+        map_tiles,              // map_blocks: one call per L1 tile
+        NULL,                   // new_with_block_shape: square only
+        map_spans,
+};
+
+A2Methods_T uarray2_methods_hierarchical =
+        &uarray2_methods_hierarchical_struct;
@@ -0,0 +1,9 @@
+#ifndef A2HIER_INCLUDED
+#define A2HIER_INCLUDED
+#include "a2methods.h"
+
+// A2Methods_T for two-level blocked arrays: 64KB-class blocks made of
+// L1-sized tiles (see uarray2h.h); map_blocks hands out tiles
+extern A2Methods_T uarray2_methods_hierarchical;
+
+#endif
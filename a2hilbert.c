@@ -0,0 +1,121 @@
+/**************************************************************
+ *
+ *                     a2hilbert.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall
+ *     Date:       October 7, 2024
+ *
+ *     Generalized Hilbert curve traversal shared by every A2Methods_T
+ *     implementation.  The curve is built by recursively splitting the
+ *     rectangle in two (when it is much wider than tall) or three
+ *     pieces, choosing split points so each piece still has a
+ *     continuous path.  This is the "gilbert" construction, so
+ *     arbitrary rectangles are covered without padding.
+ *
+ **************************************************************/
+
+#include <stdlib.h>
+
+#include "a2hilbert.h"
+
+struct walk {
+        A2Methods_UArray2 array2;
+        A2Methods_Object *(*at)(A2Methods_UArray2 array2, int i, int j);
+        A2Methods_applyfun *apply;
+        void *cl;
+};
+
+/********** sign ********
+ *
+ * Returns -1, 0, or 1 according to the sign of n
+ ************************/
+static inline int sign(int n)
+{
+        return (n > 0) - (n < 0);
+}
+
+/********** half ********
+ *
+ * Floor of n / 2 (C division truncates toward zero, which would send
+ * odd negative lengths the wrong way)
+ ************************/
+static inline int half(int n)
+{
+        return n >= 0 ? n / 2 : -((-n + 1) / 2);
+}
+
+/********** visit ********
+ *
+ * Hands cell (i, j) to the client's apply function
+ ************************/
+static inline void visit(struct walk *w, int i, int j)
+{
+        w->apply(i, j, w->array2, w->at(w->array2, i, j), w->cl);
+}
+
+/********** gilbert ********
+ *
+ * Walks the rectangle with corner (x, y), major axis (ax, ay), and minor
+ * axis (bx, by); exactly one of ax, ay and one of bx, by is nonzero.
+ * The walk starts at (x, y) and ends next to (x + ax - sign(ax), ...).
+ ************************/
+static void gilbert(struct walk *w, int x, int y,
+                    int ax, int ay, int bx, int by)
+{
+        int width  = abs(ax + ay);
+        int height = abs(bx + by);
+        int dax = sign(ax), day = sign(ay);     /* major unit step */
+        int dbx = sign(bx), dby = sign(by);     /* minor unit step */
+
+        if (height == 1) {
+                for (int k = 0; k < width; k++, x += dax, y += day)
+                        visit(w, x, y);
+                return;
+        }
+        if (width == 1) {
+                for (int k = 0; k < height; k++, x += dbx, y += dby)
+                        visit(w, x, y);
+                return;
+        }
+
+        int ax2 = half(ax), ay2 = half(ay);
+        int bx2 = half(bx), by2 = half(by);
+        int width2  = abs(ax2 + ay2);
+        int height2 = abs(bx2 + by2);
+
+        if (2 * width > 3 * height) {
+                /* long and thin: split the major axis in two */
+                if ((width2 % 2) && width > 2) {
+                        ax2 += dax;
+                        ay2 += day;
+                }
+                gilbert(w, x, y, ax2, ay2, bx, by);
+                gilbert(w, x + ax2, y + ay2, ax - ax2, ay - ay2, bx, by);
+        } else {
+                /* standard case: up the minor axis, across, back down */
+                if ((height2 % 2) && height > 2) {
+                        bx2 += dbx;
+                        by2 += dby;
+                }
+                gilbert(w, x, y, bx2, by2, ax2, ay2);
+                gilbert(w, x + bx2, y + by2, ax, ay, bx - bx2, by - by2);
+                gilbert(w, x + (ax - dax) + (bx2 - dbx),
+                           y + (ay - day) + (by2 - dby),
+                        -bx2, -by2, -(ax - ax2), -(ay - ay2));
+        }
+}
+
+void A2Hilbert_map(A2Methods_UArray2 array2, int width, int height,
+                   A2Methods_Object *at(A2Methods_UArray2 array2,
+                                        int i, int j),
+                   A2Methods_applyfun apply, void *cl)
+{
+        struct walk w = { array2, at, apply, cl };
+        if (width <= 0 || height <= 0)
+                return;
+        if (width >= height)
+                gilbert(&w, 0, 0, width, 0, 0, height);
+        else
+                gilbert(&w, 0, 0, 0, height, width, 0);
+}
@@ -0,0 +1,18 @@
+#ifndef A2HILBERT_INCLUDED
+#define A2HILBERT_INCLUDED
+#include "a2methods.h"
+
+//
+// Shared traversal used to implement map_hilbert for any A2Methods_T.
+// Visits every (i, j) with 0 <= i < width and 0 <= j < height exactly
+// once along a generalized Hilbert curve: consecutive cells are always
+// neighbors (diagonally, at most once, for some odd sizes), and any
+// width and height is allowed (not just powers of two).  Each cell is
+// fetched with 'at' and handed to 'apply'.
+//
+extern void A2Hilbert_map(A2Methods_UArray2 array2, int width, int height,
+                          A2Methods_Object *at(A2Methods_UArray2 array2,
+                                               int i, int j),
+                          A2Methods_applyfun apply, void *cl);
+
+#endif
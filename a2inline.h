@@ -0,0 +1,121 @@
+#ifndef A2INLINE_INCLUDED
+#define A2INLINE_INCLUDED
+
+/*
+ * Compile-time specialized traversals, for code that knows which
+ * representation it holds and wants no function pointers in its loops.
+ *
+ * A "view" caches the layout of a UArray2_T or UArray2b_T in a small
+ * struct, and the A2INLINE_* macros each define a static traversal
+ * over one layout in one order.  The element type and the kernel are
+ * macro arguments, so the kernel is expanded in the loop body as a
+ * direct call or macro.  The compiler can then inline it and, for
+ * simple kernels, unroll and vectorize the loop.
+ *
+ * A kernel is invoked as KERNEL(i, j, elem, cl), where elem is a
+ * TYPE *.  The A2Methods_T vtables remain the way to reach a
+ * representation chosen at run time.
+ */
+
+#include <stddef.h>
+#include "assert.h"
+#include "uarray2.h"
+#include "uarray2b.h"
+
+/* plain layout: cell (i, j) is at base + j * stride + i * size */
+typedef struct A2Inline_plain {
+        char  *base;
+        size_t stride;
+        int    width, height, size;
+} A2Inline_plain;
+
+/* blocked layout: see UArray2b_base */
+typedef struct A2Inline_blocked {
+        char  *base;
+        size_t block_bytes;
+        int    width, height, size;
+        int    block_width, block_height;
+        int    col_blocks;
+} A2Inline_blocked;
+
+static inline A2Inline_plain A2Inline_plain_view(UArray2_T array2)
+{
+        A2Inline_plain v;
+        v.base   = UArray2_base(array2);
+        v.stride = UArray2_stride(array2);
+        v.width  = UArray2_width(array2);
+        v.height = UArray2_height(array2);
+        v.size   = UArray2_size(array2);
+        return v;
+}
+
+static inline A2Inline_blocked A2Inline_blocked_view(UArray2b_T array2b)
+{
+        A2Inline_blocked v;
+        v.base         = UArray2b_base(array2b);
+        v.block_bytes  = UArray2b_block_bytes(array2b);
+        v.width        = UArray2b_width(array2b);
+        v.height       = UArray2b_height(array2b);
+        v.size         = UArray2b_size(array2b);
+        v.block_width  = UArray2b_block_width(array2b);
+        v.block_height = UArray2b_block_height(array2b);
+        v.col_blocks   = (v.width + v.block_width - 1) / v.block_width;
+        return v;
+}
+
+/* unchecked element access, for kernels that write a second array */
+static inline void *A2Inline_plain_at(const A2Inline_plain *v, int i, int j)
+{
+        return v->base + (size_t)j * v->stride + (size_t)i * v->size;
+}
+
+static inline void *A2Inline_blocked_at(const A2Inline_blocked *v,
+                                        int i, int j)
+{
+        int bcol = i / v->block_width, brow = j / v->block_height;
+        size_t block = (size_t)brow * v->col_blocks + bcol;
+        int index = (j - brow * v->block_height) * v->block_width
+                    + (i - bcol * v->block_width);
+        return v->base + block * v->block_bytes + (size_t)index * v->size;
+}
+
+/* defines 'static void NAME(const A2Inline_plain *v, void *cl)' */
+#define A2INLINE_PLAIN_ROW_MAJOR(NAME, TYPE, KERNEL)                    \
+static void NAME(const A2Inline_plain *v, void *cl)                     \
+{                                                                       \
+        assert(v->size == (int)sizeof(TYPE));                           \
+        const int w = v->width, h = v->height;                          \
+        for (int j = 0; j < h; j++) {                                   \
+                TYPE *elem = (TYPE *)(v->base + (size_t)j * v->stride); \
+                for (int i = 0; i < w; i++)                             \
+                        KERNEL(i, j, (elem + i), cl);                   \
+        }                                                               \
+}
+
+/* defines 'static void NAME(const A2Inline_blocked *v, void *cl)';
+ * blocks are visited in memory order, edge blocks clipped to the array
+ */
+#define A2INLINE_BLOCKED_BLOCK_MAJOR(NAME, TYPE, KERNEL)                \
+static void NAME(const A2Inline_blocked *v, void *cl)                   \
+{                                                                       \
+        assert(v->size == (int)sizeof(TYPE));                           \
+        const int bw = v->block_width, bh = v->block_height;            \
+        const int row_blocks = (v->height + bh - 1) / bh;               \
+        for (int brow = 0; brow < row_blocks; brow++) {                 \
+                const int j0 = brow * bh;                               \
+                const int h = v->height - j0 < bh ? v->height - j0 : bh;\
+                for (int bcol = 0; bcol < v->col_blocks; bcol++) {      \
+                        const int i0 = bcol * bw;                       \
+                        const int w = v->width - i0 < bw                \
+                                      ? v->width - i0 : bw;             \
+                        TYPE *block = (TYPE *)(v->base + v->block_bytes \
+                                * ((size_t)brow * v->col_blocks + bcol));\
+                        for (int j = 0; j < h; j++)                     \
+                                for (int i = 0; i < w; i++)             \
+                                        KERNEL(i0 + i, j0 + j,          \
+                                               (block + j * bw + i), cl);\
+                }                                                       \
+        }                                                               \
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef A2METHODS_INCLUDED
+#define A2METHODS_INCLUDED
+
+#define T A2Methods_UArray2    // for compactness
+
+typedef void *T;        // a generic two-dimensional array
+
+typedef void A2Methods_Object; // an element stored in a T
+
+// apply functions receive the column (i) and row (j) of an element,
+// the array, a pointer to the element, and a closure
+typedef void A2Methods_applyfun(int i, int j, T array2,
+                                A2Methods_Object *ptr, void *cl);
+typedef void A2Methods_mapfun(T array2, A2Methods_applyfun apply, void *cl);
+
+// small apply functions see only the element and the closure
+typedef void A2Methods_smallapplyfun(A2Methods_Object *ptr, void *cl);
+typedef void A2Methods_smallmapfun(T a2, A2Methods_smallapplyfun apply,
+                                   void *cl);
+
+// block functions receive a whole block at once: the (i, j) of its
+// upper-left element, how many columns and rows of it are in use
+// (fewer than the blocksize along the right and bottom edges), a
+// pointer to its upper-left element, and the number of bytes from one
+// row of the block to the next
+typedef void A2Methods_blockfun(int i, int j, int width, int height,
+                                A2Methods_Object *base, int stride,
+                                void *cl);
+typedef void A2Methods_blockmapfun(T array2, A2Methods_blockfun apply,
+                                   void *cl);
+
+// span functions receive a run of 'length' cells of row j, starting at
+// column i; cell i + k is at (char *)first + k * stride
+typedef void A2Methods_spanfun(int i, int j, int length,
+                               A2Methods_Object *first, int stride,
+                               void *cl);
+typedef void A2Methods_spanmapfun(T array2, A2Methods_spanfun apply,
+                                  void *cl);
+
+//
+// An A2Methods_T is a pointer to a struct of function pointers that
+// together implement a polymorphic two-dimensional array.  Any mapping
+// function a particular representation cannot support efficiently
+// is NULL.  New members are only ever added at the end, so that code
+// compiled against an older layout keeps working.
+//
+typedef struct A2Methods_T {
+        // creates a distinct 2D array of memory cells, each of the given
+        // 'size'; each cell is uninitialized
+        T    (*new)(int width, int height, int size);
+
+        // creates a distinct 2D array of memory cells, each of the given
+        // 'size', but for blocked arrays using the given 'blocksize'
+        T    (*new_with_blocksize)(int width, int height, int size,
+                                   int blocksize);
+
+        // frees *array2p and overwrites the pointer with NULL
+        void (*free)(T *array2p);
+
+        // observe properties of the array
+        int (*width)    (T array2);
+        int (*height)   (T array2);
+        int (*size)     (T array2);
+        int (*blocksize)(T array2);   // for an unblocked array, returns 1
+
+        // returns a pointer to the object in column i, row j
+        // (checked runtime error if i or j is out of bounds)
+        A2Methods_Object *(*at)(T array2, int i, int j);
+
+        // mapping functions
+        A2Methods_mapfun *map_row_major;
+        A2Methods_mapfun *map_col_major;
+        A2Methods_mapfun *map_block_major;
+        A2Methods_mapfun *map_default;  // the most efficient of the above
+
+        // alternative mapping functions that pass only the element
+        A2Methods_smallmapfun *small_map_row_major;
+        A2Methods_smallmapfun *small_map_col_major;
+        A2Methods_smallmapfun *small_map_block_major;
+        A2Methods_smallmapfun *small_map_default;
+
+        // visits every element along a generalized Hilbert curve, which
+        // handles any width and height; may be NULL
+        A2Methods_mapfun      *map_hilbert;
+        A2Methods_smallmapfun *small_map_hilbert;
+
+        // calls 'apply' once per block, in block-major order; NULL for
+        // representations whose blocks are not stored row by row
+        A2Methods_blockmapfun *map_blocks;
+
+        // like new_with_blocksize, but blocked arrays get blocks of
+        // 'block_width' columns by 'block_height' rows; unblocked arrays
+        // ignore the shape.  NULL if only square blocks are supported
+        T    (*new_with_block_shape)(int width, int height, int size,
+                                     int block_width, int block_height);
+
+        // visits every element exactly once, a horizontal run at a time,
+        // in the representation's storage order: whole rows for plain
+        // arrays, block rows for blocked arrays, and as long a run as the
+        // layout keeps contiguous otherwise
+        A2Methods_spanmapfun *map_spans;
+} *A2Methods_T;
+
+#undef T
+#endif
@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "a2morton.h"
+#include "a2hilbert.h"
+#include "uarray2m.h"
+
+// define a private version of each function in A2Methods_T that we implement
+
+typedef A2Methods_UArray2 A2;   // private abbreviation
+
+static A2 new(int width, int height, int size)
+{
+        return UArray2m_new(width, height, size);
+}
+
+static A2 new_with_blocksize(int width, int height, int size, int blocksize)
+{
+        (void) blocksize;       // Z-order needs no blocksize
+        return UArray2m_new(width, height, size);
+}
+
+static A2 new_with_block_shape(int width, int height, int size,
+                               int block_width, int block_height)
+{
+        (void) block_width;     // nor a block shape
+        (void) block_height;
+        return UArray2m_new(width, height, size);
+}
+
+static void a2free(A2 * array2p)
+{
+        UArray2m_free((UArray2m_T *) array2p);
+}
+
+static int width(A2 array2)
+{
+        return UArray2m_width(array2);
+}
+static int height(A2 array2)
+{
+        return UArray2m_height(array2);
+}
+static int size(A2 array2)
+{
+        return UArray2m_size(array2);
+}
+static int blocksize(A2 array2)
+{
+        return UArray2m_tilesize(array2);
+}
+
+static A2Methods_Object *at(A2 array2, int i, int j)
+{
+        return UArray2m_at(array2, i, j);
+}
+
+typedef void applyfun(int i, int j, UArray2m_T array2m, void *elem, void *cl);
+
+static void map_morton(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        UArray2m_map(array2, (applyfun *) apply, cl);
+}
+
+typedef void spanfun(int col, int row, int length, void *first, int stride,
+                     void *cl);
+
+static void map_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+        UArray2m_map_spans(array2, (spanfun *) apply, cl);
+}
+
+static void map_hilbert(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        A2Hilbert_map(array2, width(array2), height(array2), at, apply, cl);
+}
+
+struct small_closure {
+        A2Methods_smallapplyfun *apply;
+        void *cl;
+};
+
+static void apply_small(int i, int j, UArray2m_T array2, void *elem, void *vcl)
+{
+        struct small_closure *cl = vcl;
+        (void)i;
+        (void)j;
+        (void)array2;
+        cl->apply(elem, cl->cl);
+}
+
+static void small_map_morton(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        UArray2m_map(a2, apply_small, &mycl);
+}
+
+static void small_map_hilbert(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        map_hilbert(a2, (A2Methods_applyfun *) apply_small, &mycl);
+}
+
+// Z-order is block-major at every scale, so it fills the block-major slots
+
+static struct A2Methods_T uarray2_methods_morton_struct = {
+        new,
+        new_with_blocksize,
+        a2free,
+        width,
+        height,
+        size,
+        blocksize,
+        at,
+        NULL,                   // map_row_major
+        NULL,                   // map_col_major
+        map_morton,             // map_block_major
+        map_morton,             // map_default
+        NULL,                   // small_map_row_major
+        NULL,                   // small_map_col_major
+        small_map_morton,       // small_map_block_major
+        small_map_morton,       // small_map_default
+        map_hilbert,
+        small_map_hilbert,
+        NULL,                   // map_blocks: cells are not stored in rows
+        new_with_block_shape,
+        map_spans,              // pairs of cells: all Z-order keeps together
+};
+
+A2Methods_T uarray2_methods_morton = &uarray2_methods_morton_struct;
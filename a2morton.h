@@ -0,0 +1,9 @@
+#ifndef A2MORTON_INCLUDED
+#define A2MORTON_INCLUDED
+#include "a2methods.h"
+
+// A2Methods_T for arrays stored in Morton (Z-order); map_default
+// (and map_block_major) walks memory linearly
+extern A2Methods_T uarray2_methods_morton;
+
+#endif
@@ -13,7 +13,8 @@
  **************************************************************/
 
 #include <string.h>
-#include <a2plain.h>
+#include "a2plain.h"
+#include "a2hilbert.h"
 #include "uarray2.h"
 
 /********** new ********
@@ -68,6 +69,33 @@ static A2Methods_UArray2 new_with_blocksize(int width, int height, int size,
         return UArray2_new(width, height, size);
 }
 
+/********** new_with_block_shape ********
+ *
+ * Creates a new 2D array with the specified width, height, and element size;
+ * plain arrays have no blocks, so the block shape is ignored
+ *
+ * Parameters:
+ *      int width:        number of columns in the array
+ *      int height:       number of rows in the array
+ *      int size:         size (in bytes) of each element in the array
+ *      int block_width:  block width for arrays (ignored)
+ *      int block_height: block height for arrays (ignored)
+ *
+ * Return:
+ *      `A2Methods_UArray2` representing a new 2D array.
+ *
+ * Expects:
+ *      `width`, `height`, and `size` must be positive integers
+ ************************/
+static A2Methods_UArray2 new_with_block_shape(int width, int height, int size,
+                                              int block_width,
+                                              int block_height)
+{
+        (void) block_width;
+        (void) block_height;
+        return UArray2_new(width, height, size);
+}
+
 /********** a2free ********
  *
  * Frees all memory from 2D array `UArray2_T`.
@@ -317,6 +345,78 @@ static void small_map_col_major(A2Methods_UArray2        a2,
         UArray2_map_col_major(a2, apply_small, &mycl);
 }
 
+/********** map_hilbert ********
+ *
+ * Applies a specific function to each element in a 2D array along a
+ * generalized Hilbert curve
+ *
+ * Parameters:
+ *      A2Methods_UArray2 uarray2: array that is traversed
+ *      A2Methods_applyfun apply:  function to apply to every element in array
+ *      void *cl:                  closure pointer for additional data
+ *
+ * Return:
+ *      none
+ *
+ * Expects:
+ *      `uarray2` is a valid, non-NULL `A2Methods_UArray2`.
+ *      `apply` is a valid function pointer.
+ ************************/
+static void map_hilbert(A2Methods_UArray2 uarray2,
+                        A2Methods_applyfun apply,
+                        void *cl)
+{
+        A2Hilbert_map(uarray2, UArray2_width(uarray2),
+                      UArray2_height(uarray2), at, apply, cl);
+}
+
+/********** small_map_hilbert ********
+ *
+ * Applies small function to every element in 2D array along a
+ * generalized Hilbert curve
+ *
+ * Parameters:
+ *      A2Methods_UArray2 a2:          array needed to be traversed
+ *      A2Methods_smallapplyfun apply: small function to apply to every element
+ *      void *cl:                      closure pointer for additional data
+ *
+ * Return:
+ *      none
+ *
+ * Expects:
+ *      `a2` is a valid, non-NULL `A2Methods_UArray2`.
+ *
+ ************************/
+static void small_map_hilbert(A2Methods_UArray2        a2,
+                              A2Methods_smallapplyfun  apply,
+                              void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        map_hilbert(a2, (A2Methods_applyfun *)apply_small, &mycl);
+}
+
+/********** map_spans ********
+ *
+ * Applies a span function to each row of a 2D array, top to bottom
+ *
+ * Parameters:
+ *      A2Methods_UArray2 uarray2: array that is traversed
+ *      A2Methods_spanfun apply:   function to apply to every row
+ *      void *cl:                  closure pointer for additional data
+ *
+ * Return:
+ *      none
+ *
+ * Expects:
+ *      `uarray2` is a valid, non-NULL `A2Methods_UArray2`.
+ *      `apply` is a valid function pointer.
+ ************************/
+static void map_spans(A2Methods_UArray2 uarray2, A2Methods_spanfun apply,
+                      void *cl)
+{
+        UArray2_map_row_spans(uarray2, (UArray2_spanfun *)apply, cl);
+}
+
 /* Implementation of 'A2Methods_T' interface for unboxed 2D arrays */
 static struct A2Methods_T uarray2_methods_plain_struct = {
         new,
@@ -334,7 +434,12 @@ static struct A2Methods_T uarray2_methods_plain_struct = {
         small_map_row_major,
         small_map_col_major,
         NULL,
-        small_map_row_major
+        small_map_row_major,
+        map_hilbert,
+        small_map_hilbert,
+        NULL,                   /* map_blocks */
+        new_with_block_shape,
+        map_spans
 };
 
 /* Exported pointer to the `A2Methods_T` struct, allowing access to the plain
@@ -0,0 +1,8 @@
+#ifndef A2PLAIN_INCLUDED
+#define A2PLAIN_INCLUDED
+#include "a2methods.h"
+
+// A2Methods_T for plain (row-major, unblocked) arrays
+extern A2Methods_T uarray2_methods_plain;
+
+#endif
@@ -1,9 +1,12 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "assert.h"
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2morton.h"
+#include "a2hier.h"
 
 
 #define W 13
@@ -113,6 +116,60 @@ bool has_blocked_methods(A2Methods_T m)
         return m->map_default != NULL && m->map_block_major != NULL;
 }
 
+static void check_position(int i, int j, A2 a, void *elem, void *cl)
+{
+        (void)a;
+        unsigned *p = elem;
+        int *counter = cl;
+
+        assert(*p == 1000u * i + j);
+        *counter += 1;
+}
+
+struct hilbert_state {
+        int visited;
+        int last_i, last_j;
+};
+
+/* every step of a Hilbert walk moves to a neighboring cell (a diagonal
+ * step is occasionally unavoidable when the dimensions are not both even) */
+static void check_hilbert_step(int i, int j, A2 a, void *elem, void *cl)
+{
+        struct hilbert_state *state = cl;
+        check_position(i, j, a, elem, &state->visited);
+        if (state->visited > 1)
+                assert(abs(i - state->last_i) <= 1 &&
+                       abs(j - state->last_j) <= 1);
+        state->last_i = i;
+        state->last_j = j;
+}
+
+/* checks a whole block against the positions of its cells */
+static void check_block(int i, int j, int width, int height, void *base,
+                        int stride, void *cl)
+{
+        int *counter = cl;
+        for (int r = 0; r < height; r++) {
+                unsigned *p = (unsigned *)((char *)base + r * stride);
+                for (int c = 0; c < width; c++) {
+                        assert(p[c] == 1000u * (i + c) + (j + r));
+                        *counter += 1;
+                }
+        }
+}
+
+/* checks every cell of a span against its position */
+static void check_span(int i, int j, int length, void *first, int stride,
+                       void *cl)
+{
+        int *counter = cl;
+        for (int k = 0; k < length; k++) {
+                unsigned *p = (unsigned *)((char *)first + k * stride);
+                assert(*p == 1000u * (i + k) + j);
+                *counter += 1;
+        }
+}
+
 static inline void copy_unsigned(A2Methods_T methods, A2 a,
                                  int i, int j, unsigned n) 
 {
@@ -157,6 +214,24 @@ static void test_methods(A2Methods_T methods_under_test)
                         assert(*p == n);
                 }
         }
+        int visited = 0;
+        methods->map_default(array, check_position, &visited);
+        assert(visited == W * H);
+        if (methods->map_blocks) {
+                visited = 0;
+                methods->map_blocks(array, check_block, &visited);
+                assert(visited == W * H);
+        }
+        if (methods->map_spans) {
+                visited = 0;
+                methods->map_spans(array, check_span, &visited);
+                assert(visited == W * H);
+        }
+        if (methods->map_hilbert) {
+                struct hilbert_state state = { 0, -1, -1 };
+                methods->map_hilbert(array, check_hilbert_step, &state);
+                assert(state.visited == W * H);
+        }
         double_row_major_plus();
         methods->free(&array);
 }
@@ -167,6 +242,8 @@ int main(int argc, char *argv[])
         (void)argv;
         test_methods(uarray2_methods_plain);
         /*  test_methods(uarray2_methods_blocked); */
+        test_methods(uarray2_methods_morton);
+        test_methods(uarray2_methods_hierarchical);
         printf("Passed.\n");  /* only if we reach this point without
                                * assertion failure
                                */
@@ -0,0 +1,138 @@
+/**************************************************************
+ *
+ *                     cacheinfo.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall
+ *     Date:       October 7, 2024
+ *
+ *     Finds the sizes of the data caches so that blocked arrays can
+ *     size their blocks for the machine at hand rather than a single
+ *     hard-coded constant.
+ *
+ **************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cacheinfo.h"
+
+enum { MAX_LEVEL = 3, FALLBACK_BLOCK_BYTES = 64 * 1024 };
+
+static long sizes[MAX_LEVEL + 1];       /* sizes[level], 0 if unknown */
+static int  probed = 0;
+
+/********** sysconf_size ********
+ *
+ * Asks the C library for the size of a cache level; 0 if it cannot say
+ ************************/
+static long sysconf_size(int level)
+{
+        long n = -1;
+        switch (level) {
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+        case 1: n = sysconf(_SC_LEVEL1_DCACHE_SIZE); break;
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+        case 2: n = sysconf(_SC_LEVEL2_CACHE_SIZE);  break;
+#endif
+#ifdef _SC_LEVEL3_CACHE_SIZE
+        case 3: n = sysconf(_SC_LEVEL3_CACHE_SIZE);  break;
+#endif
+        default: break;
+        }
+        return n > 0 ? n : 0;
+}
+
+/********** read_line ********
+ *
+ * Reads the first line of a small sysfs file into buf; returns 0 on
+ * failure
+ ************************/
+static int read_line(const char *path, char *buf, int len)
+{
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL)
+                return 0;
+        int ok = fgets(buf, len, fp) != NULL;
+        fclose(fp);
+        if (ok)
+                buf[strcspn(buf, "\n")] = '\0';
+        return ok;
+}
+
+/********** sysfs_size ********
+ *
+ * Scans /sys/devices/system/cpu/cpu0/cache for a data or unified cache
+ * at the given level; sizes there look like "48K" or "2048K"
+ ************************/
+static long sysfs_size(int level)
+{
+        char path[128], buf[64];
+        for (int index = 0; ; index++) {
+                const char *dir = "/sys/devices/system/cpu/cpu0/cache";
+                snprintf(path, sizeof path, "%s/index%d/level", dir, index);
+                if (!read_line(path, buf, sizeof buf))
+                        return 0;
+                if (atoi(buf) != level)
+                        continue;
+                snprintf(path, sizeof path, "%s/index%d/type", dir, index);
+                if (!read_line(path, buf, sizeof buf) ||
+                    strcmp(buf, "Instruction") == 0)
+                        continue;
+                snprintf(path, sizeof path, "%s/index%d/size", dir, index);
+                if (!read_line(path, buf, sizeof buf))
+                        continue;
+                char *unit;
+                long n = strtol(buf, &unit, 10);
+                if (*unit == 'K')
+                        n *= 1024;
+                else if (*unit == 'M')
+                        n *= 1024 * 1024;
+                return n > 0 ? n : 0;
+        }
+}
+
+/********** probe ********
+ *
+ * Fills in 'sizes' the first time any function here is called
+ ************************/
+static void probe(void)
+{
+        if (probed)
+                return;
+        for (int level = 1; level <= MAX_LEVEL; level++) {
+                sizes[level] = sysconf_size(level);
+                if (sizes[level] == 0)
+                        sizes[level] = sysfs_size(level);
+        }
+        probed = 1;
+}
+
+long Cache_size(int level)
+{
+        if (level < 1 || level > MAX_LEVEL)
+                return 0;
+        probe();
+        return sizes[level];
+}
+
+int Cache_target_level(void)
+{
+        probe();
+        if (sizes[2] > 0)
+                return 2;
+        if (sizes[1] > 0)
+                return 1;
+        return 0;
+}
+
+long Cache_block_bytes(void)
+{
+        int level = Cache_target_level();
+        if (level == 0)
+                return FALLBACK_BLOCK_BYTES;
+        return sizes[level] / 2;        /* room for source + destination */
+}
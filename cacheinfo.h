@@ -0,0 +1,25 @@
+#ifndef CACHEINFO_INCLUDED
+#define CACHEINFO_INCLUDED
+
+/*
+ * Reports the data cache hierarchy of the machine we are running on,
+ * read once from sysconf (or sysfs when sysconf does not know).
+ */
+
+/* size in bytes of the level-'level' data (or unified) cache of one
+ * core, or 0 if it cannot be determined; 1 <= level <= 3
+ */
+extern long Cache_size(int level);
+
+/* the cache level that blocked arrays should be tuned for: L2 when
+ * its size is known, else L1, else 0 (unknown)
+ */
+extern int  Cache_target_level(void);
+
+/* bytes one block may occupy so that a source block plus a destination
+ * block fit in the target level together; falls back to 64KB when
+ * nothing is known about the caches
+ */
+extern long Cache_block_bytes(void);
+
+#endif
@@ -0,0 +1,129 @@
+/**************************************************************
+ *
+ *                     pixfmt.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall
+ *     Date:       October 7, 2024
+ *
+ *     Compact pixel formats.  An 8-bit image in 3 or 4 bytes per
+ *     pixel is a quarter to a third of the struct Pnm_rgb array, and
+ *     a transform that only moves pixels runs at memory speed, so the
+ *     transform gets that much faster.  A planar image goes further:
+ *     each plane is a plain array of bytes, which the SIMD kernels of
+ *     tile.h move sixteen or more at a time.
+ *
+ **************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "assert.h"
+#include "pixfmt.h"
+
+int Pixfmt_size(Pixfmt fmt)
+{
+        switch (fmt) {
+        case PIXFMT_WIDE:    return sizeof(struct Pnm_rgb);
+        case PIXFMT_RGB8:    return 3;
+        case PIXFMT_RGBX8:   return 4;
+        case PIXFMT_RGB16:   return 6;
+        case PIXFMT_RGBX16:  return 8;
+        case PIXFMT_RGB16BE: return 6;
+        }
+        assert(0);
+        return 0;
+}
+
+const char *Pixfmt_name(Pixfmt fmt)
+{
+        switch (fmt) {
+        case PIXFMT_WIDE:    return "wide";
+        case PIXFMT_RGB8:    return "rgb8";
+        case PIXFMT_RGBX8:   return "rgbx8";
+        case PIXFMT_RGB16:   return "rgb16";
+        case PIXFMT_RGBX16:  return "rgbx16";
+        case PIXFMT_RGB16BE: return "rgb16be";
+        }
+        assert(0);
+        return NULL;
+}
+
+Pixfmt Pixfmt_packed(unsigned denominator, bool aligned)
+{
+        assert(denominator > 0 && denominator <= 65535);
+        if (denominator <= 255)
+                return aligned ? PIXFMT_RGBX8 : PIXFMT_RGB8;
+        return aligned ? PIXFMT_RGBX16 : PIXFMT_RGB16;
+}
+
+void Pixfmt_pack(Pixfmt fmt, const struct Pnm_rgb *rgb, void *cell)
+{
+        uint8_t  *b = cell;
+        uint16_t  s[4];
+
+        switch (fmt) {
+        case PIXFMT_WIDE:
+                memcpy(cell, rgb, sizeof(*rgb));
+                return;
+        case PIXFMT_RGBX8:
+                b[3] = 0;
+                /* FALLTHROUGH */
+        case PIXFMT_RGB8:
+                assert(rgb->red <= 255 && rgb->green <= 255
+                       && rgb->blue <= 255);
+                b[0] = rgb->red;
+                b[1] = rgb->green;
+                b[2] = rgb->blue;
+                return;
+        case PIXFMT_RGB16:
+        case PIXFMT_RGBX16:
+                s[0] = rgb->red;
+                s[1] = rgb->green;
+                s[2] = rgb->blue;
+                s[3] = 0;
+                memcpy(cell, s, Pixfmt_size(fmt));   /* cell may be odd */
+                return;
+        case PIXFMT_RGB16BE:
+                b[0] = rgb->red >> 8;   b[1] = rgb->red & 0xff;
+                b[2] = rgb->green >> 8; b[3] = rgb->green & 0xff;
+                b[4] = rgb->blue >> 8;  b[5] = rgb->blue & 0xff;
+                return;
+        }
+}
+
+void Pixfmt_unpack(Pixfmt fmt, const void *cell, struct Pnm_rgb *rgb)
+{
+        const uint8_t *b = cell;
+        uint16_t       s[4];
+
+        switch (fmt) {
+        case PIXFMT_WIDE:
+                memcpy(rgb, cell, sizeof(*rgb));
+                return;
+        case PIXFMT_RGB8:
+        case PIXFMT_RGBX8:
+                rgb->red   = b[0];
+                rgb->green = b[1];
+                rgb->blue  = b[2];
+                return;
+        case PIXFMT_RGB16:
+        case PIXFMT_RGBX16:
+                memcpy(s, cell, Pixfmt_size(fmt));
+                rgb->red   = s[0];
+                rgb->green = s[1];
+                rgb->blue  = s[2];
+                return;
+        case PIXFMT_RGB16BE:
+                rgb->red   = b[0] << 8 | b[1];
+                rgb->green = b[2] << 8 | b[3];
+                rgb->blue  = b[4] << 8 | b[5];
+                return;
+        }
+}
+
+int Pixfmt_plane_size(unsigned denominator)
+{
+        assert(denominator > 0 && denominator <= 65535);
+        return denominator <= 255 ? 1 : 2;
+}
@@ -0,0 +1,48 @@
+#ifndef PIXFMT_INCLUDED
+#define PIXFMT_INCLUDED
+
+/*
+ * Pixel storage formats: the wide struct Pnm_rgb, three unsigneds (12
+ * bytes) per pixel, and compact forms of 3 to 8 bytes, which every
+ * A2Methods_T suite and every rotate.h engine can move.  ppmio.h reads
+ * and writes images in any of them.
+ */
+
+#include <stdbool.h>
+#include "a2methods.h"
+#include "pnm.h"
+
+typedef enum Pixfmt {
+        PIXFMT_WIDE = 0,        /* struct Pnm_rgb, 12 bytes */
+        PIXFMT_RGB8,            /* r, g, b bytes, 3 bytes */
+        PIXFMT_RGBX8,           /* r, g, b bytes and a pad byte, 4 bytes */
+        PIXFMT_RGB16,           /* r, g, b uint16_t, 6 bytes */
+        PIXFMT_RGBX16,          /* r, g, b uint16_t and a pad, 8 bytes */
+        PIXFMT_RGB16BE          /* r, g, b big-endian, 6 bytes: the cells
+                                   of a raw 16-bit raster as it is */
+} Pixfmt;
+
+/* bytes per pixel, and a printable name ("rgb8", ...) */
+extern int         Pixfmt_size(Pixfmt fmt);
+extern const char *Pixfmt_name(Pixfmt fmt);
+
+/* the compact format for samples up to 'denominator': 3 bytes per
+ * pixel (6 past 255), or 4 (8) if 'aligned'
+ */
+extern Pixfmt Pixfmt_packed(unsigned denominator, bool aligned);
+
+/* convert one pixel; samples must fit the format */
+extern void Pixfmt_pack  (Pixfmt fmt, const struct Pnm_rgb *rgb, void *cell);
+extern void Pixfmt_unpack(Pixfmt fmt, const void *cell, struct Pnm_rgb *rgb);
+
+/*
+ * Planar images: red, green and blue each in an array of their own,
+ * of 1-byte samples (2 past 255), so every transform moves one small
+ * sample per cell and runs once per plane.  ppmio.h reads and writes
+ * the planes directly.
+ */
+
+/* bytes per sample of a plane holding samples up to 'denominator' */
+extern int Pixfmt_plane_size(unsigned denominator);
+
+#endif
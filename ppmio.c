@@ -0,0 +1,1361 @@
+/**************************************************************
+ *
+ *                     ppmio.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall
+ *     Date:       October 7, 2024
+ *
+ *     Reading and writing PPMs in the compact pixel formats.  The
+ *     course reader goes a sample at a time into struct Pnm_rgb,
+ *     which for a 16-bit image is twice the memory of RGB16 plus a
+ *     conversion pass; here each raw row is one fread, and its
+ *     big-endian samples are swapped straight into the cells, or
+ *     scattered into the three planes of a planar image.  Output
+ *     goes the other way, encoded a megabyte at a time and written
+ *     with write/writev rather than stdio.
+ *
+ **************************************************************/
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "assert.h"
+#include "a2blocked.h"
+#include "a2inline.h"
+#include "a2plain.h"
+#include "uarray2.h"
+#include "ppmio.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PPMIO_X86 1
+#endif
+
+/*
+ * The rows of an image as contiguous runs of cells.  Rows of the plain
+ * suite are contiguous already.  Rows of a blocked suite are staged a
+ * band of block_height rows at a time in 'scratch': a band is stored,
+ * or gathered, block by block, each block row one memcpy, so the slab
+ * is gone through front to back.  For any other suite a row goes
+ * through 'scratch' and is copied a cell at a time.
+ */
+struct rows {
+        const struct A2Methods_T *methods;      /* as in Pnm_ppm */
+        A2Methods_UArray2         pixels;
+        int                       width, height, size;
+        char                     *scratch;      /* NULL if plain */
+        bool                      blocked;
+        A2Inline_blocked          view;         /* if blocked */
+};
+
+static struct rows rows_new(const struct A2Methods_T *methods,
+                            A2Methods_UArray2 pixels)
+{
+        struct rows r;
+        r.methods = methods;
+        r.pixels  = pixels;
+        r.width   = methods->width(pixels);
+        r.height  = methods->height(pixels);
+        r.size    = methods->size(pixels);
+        r.scratch = NULL;
+        r.blocked = A2Blocked_is_blocked(methods);
+        int band  = 1;
+        if (r.blocked) {
+                r.view = A2Inline_blocked_view(pixels);
+                band   = r.view.block_height;
+        }
+        if (methods != uarray2_methods_plain) {
+                r.scratch = malloc((size_t)band * r.width * r.size);
+                assert(r.scratch != NULL);
+        }
+        return r;
+}
+
+/* where to decode row 'row'; rows_put stores it */
+static char *rows_buffer(struct rows *r, int row)
+{
+        if (r->blocked)
+                return r->scratch + (size_t)(row % r->view.block_height)
+                                    * r->width * r->size;
+        return r->scratch ? r->scratch
+                          : (char *)r->methods->at(r->pixels, 0, row);
+}
+
+/********** move_band ********
+ *
+ * Copies the staged rows 'first' to 'first + n - 1', which make up one
+ * row of blocks, into the blocks ('put') or out of them, in slab order
+ ************************/
+static void move_band(struct rows *r, int first, int n, bool put)
+{
+        const A2Inline_blocked *v = &r->view;
+        const size_t row_bytes   = (size_t)r->width * r->size;
+        const size_t block_row   = (size_t)v->block_width * r->size;
+        char *block = v->base + (size_t)(first / v->block_height)
+                                * v->col_blocks * v->block_bytes;
+
+        for (int b = 0; b < v->col_blocks; b++, block += v->block_bytes) {
+                const int col  = b * v->block_width;
+                const int cols = r->width - col < v->block_width
+                                 ? r->width - col : v->block_width;
+                char *staged = r->scratch + (size_t)col * r->size;
+                for (int k = 0; k < n; k++) {
+                        char *cells = block + k * block_row;
+                        char *row   = staged + k * row_bytes;
+                        memcpy(put ? cells : row, put ? row : cells,
+                               (size_t)cols * r->size);
+                }
+        }
+}
+
+/* the number of rows in the band holding 'row' */
+static int band_rows(struct rows *r, int row)
+{
+        const int band = r->view.block_height;
+        const int first = row - row % band;
+        return r->height - first < band ? r->height - first : band;
+}
+
+static void rows_put(struct rows *r, int row)
+{
+        if (r->scratch == NULL)
+                return;
+        if (r->blocked) {
+                const int band = r->view.block_height;
+                if (row % band == band_rows(r, row) - 1)
+                        move_band(r, row - row % band, band_rows(r, row),
+                                  true);
+                return;
+        }
+        for (int i = 0; i < r->width; i++)
+                memcpy(r->methods->at(r->pixels, i, row),
+                       r->scratch + (size_t)i * r->size, r->size);
+}
+
+/* row 'row' as contiguous cells, gathered if need be; rows of a
+ * blocked suite must be asked for in order
+ */
+static const char *rows_get(struct rows *r, int row)
+{
+        if (r->scratch == NULL)
+                return r->methods->at(r->pixels, 0, row);
+        if (r->blocked) {
+                const int band = r->view.block_height;
+                if (row % band == 0)
+                        move_band(r, row, band_rows(r, row), false);
+                return rows_buffer(r, row);
+        }
+        for (int i = 0; i < r->width; i++)
+                memcpy(r->scratch + (size_t)i * r->size,
+                       r->methods->at(r->pixels, i, row), r->size);
+        return r->scratch;
+}
+
+static void rows_free(struct rows *r)
+{
+        free(r->scratch);
+}
+
+/********** skip_space ********
+ *
+ * Skips whitespace and '#' comments in a PPM header
+ ************************/
+static void skip_space(FILE *fp)
+{
+        int c;
+        while ((c = getc(fp)) != EOF) {
+                if (c == '#') {
+                        while ((c = getc(fp)) != '\n' && c != EOF)
+                                ;
+                } else if (!isspace(c)) {
+                        ungetc(c, fp);
+                        return;
+                }
+        }
+}
+
+/********** read_number ********
+ *
+ * Reads a decimal number after any whitespace; false if there is none
+ * or it is over 'limit'
+ ************************/
+static bool read_number(FILE *fp, unsigned limit, unsigned *n)
+{
+        int c, digits = 0;
+        unsigned long v = 0;
+
+        skip_space(fp);
+        while ((c = getc(fp)) != EOF && isdigit(c)) {
+                v = v * 10 + (c - '0');
+                if (v > limit)
+                        return false;
+                digits++;
+        }
+        if (c != EOF)
+                ungetc(c, fp);
+        *n = v;
+        return digits > 0;
+}
+
+/********** read_header ********
+ *
+ * Reads a PPM header up to the first sample; false if it is not one.
+ * '*raw' is set for P6, whose raster starts right after.
+ ************************/
+static bool read_header(FILE *fp, bool *raw, unsigned *width,
+                        unsigned *height, unsigned *denominator)
+{
+        int magic0 = getc(fp), magic1 = getc(fp);
+        if (magic0 != 'P' || (magic1 != '6' && magic1 != '3')
+            || !read_number(fp, 1u << 30, width)
+            || !read_number(fp, 1u << 30, height)
+            || !read_number(fp, 65535, denominator)
+            || *width == 0 || *height == 0 || *denominator == 0)
+                return false;
+        *raw = magic1 == '6';
+        return !*raw || isspace(getc(fp));  /* one byte before the raster */
+}
+
+/********** decode_row ********
+ *
+ * Decodes 'width' raw pixels from 'in' (samples of 'bytes' bytes,
+ * big-endian) into cells of 'fmt' at 'out'
+ *
+ * Notes:
+ *      - the raw layout of a 1-byte row is RGB8, and of a 2-byte row
+ *        RGB16BE, or RGB16 with its bytes swapped, so those are a
+ *        copy and a swap
+ ************************/
+static void decode_row(Pixfmt fmt, const uint8_t *in, int bytes, char *out,
+                       int width)
+{
+        const int n = 3 * width;
+        uint8_t  *o8  = (uint8_t *)out;
+        uint16_t *o16 = (uint16_t *)out;
+
+        if ((fmt == PIXFMT_RGB8 && bytes == 1)
+            || (fmt == PIXFMT_RGB16BE && bytes == 2)) {
+                memcpy(out, in, (size_t)n * bytes);
+        } else if (fmt == PIXFMT_RGBX8 && bytes == 1) {
+                for (int k = 0; k < width; k++, in += 3, o8 += 4) {
+                        o8[0] = in[0];
+                        o8[1] = in[1];
+                        o8[2] = in[2];
+                        o8[3] = 0;
+                }
+        } else if (fmt == PIXFMT_RGB16 && bytes == 2) {
+                for (int k = 0; k < n; k++)
+                        o16[k] = (uint16_t)(in[2 * k] << 8 | in[2 * k + 1]);
+        } else if (fmt == PIXFMT_RGBX16 && bytes == 2) {
+                for (int k = 0; k < width; k++, in += 6, o16 += 4) {
+                        o16[0] = (uint16_t)(in[0] << 8 | in[1]);
+                        o16[1] = (uint16_t)(in[2] << 8 | in[3]);
+                        o16[2] = (uint16_t)(in[4] << 8 | in[5]);
+                        o16[3] = 0;
+                }
+        } else if (fmt == PIXFMT_WIDE && bytes == 1) {
+                struct Pnm_rgb *rgb = (struct Pnm_rgb *)out;
+                for (int k = 0; k < width; k++, in += 3) {
+                        rgb[k].red   = in[0];
+                        rgb[k].green = in[1];
+                        rgb[k].blue  = in[2];
+                }
+        } else {
+                const int size = Pixfmt_size(fmt);
+                for (int k = 0; k < width; k++, in += 3 * bytes) {
+                        struct Pnm_rgb rgb;
+                        rgb.red   = bytes == 1 ? in[0] : in[0] << 8 | in[1];
+                        rgb.green = bytes == 1 ? in[1] : in[2] << 8 | in[3];
+                        rgb.blue  = bytes == 1 ? in[2] : in[4] << 8 | in[5];
+                        Pixfmt_pack(fmt, &rgb, out + (size_t)k * size);
+                }
+        }
+}
+
+#ifdef PPMIO_X86
+/*
+ * Vector encoders for encode_row.  Each handles a prefix of the row
+ * and returns how many pixels (or samples) it did; the scalar loop in
+ * encode_row finishes the rest.  No store reaches past the end of the
+ * row, so a row may be encoded straight into a mapped file.
+ */
+
+/* RGBX8 to RGB8: 4 pixels per shuffle */
+__attribute__((target("ssse3")))
+static int encode_rgbx8_ssse3(const uint8_t *in, uint8_t *out, int width)
+{
+        const __m128i pick = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10,
+                                           12, 13, 14, -1, -1, -1, -1);
+        int k = 0;
+        for (; k + 6 <= width; k += 4) {        /* 16-byte store fits */
+                __m128i v = _mm_loadu_si128((const __m128i *)(in + 4 * k));
+                _mm_storeu_si128((__m128i *)(out + 3 * k),
+                                 _mm_shuffle_epi8(v, pick));
+        }
+        return k;
+}
+
+/* RGBX16 to big-endian 6-byte pixels: 2 pixels per shuffle */
+__attribute__((target("ssse3")))
+static int encode_rgbx16_ssse3(const uint16_t *in, uint8_t *out, int width)
+{
+        const __m128i pick = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 9, 8, 11, 10,
+                                           13, 12, -1, -1, -1, -1);
+        int k = 0;
+        for (; k + 3 <= width; k += 2) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(in + 4 * k));
+                _mm_storeu_si128((__m128i *)(out + 6 * k),
+                                 _mm_shuffle_epi8(v, pick));
+        }
+        return k;
+}
+
+/* 16-bit samples to big-endian: 8 samples per swap */
+__attribute__((target("sse2")))
+static int encode_rgb16_sse2(const uint16_t *in, uint8_t *out, int n)
+{
+        int k = 0;
+        for (; k + 8 <= n; k += 8) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(in + k));
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                _mm_storeu_si128((__m128i *)(out + 2 * k), v);
+        }
+        return k;
+}
+
+/* unsigned samples to bytes: 16 samples per two rounds of packing */
+__attribute__((target("sse2")))
+static int encode_wide8_sse2(const unsigned *in, uint8_t *out, int n)
+{
+        const __m128i low = _mm_set1_epi32(0xff);
+        int k = 0;
+        for (; k + 16 <= n; k += 16) {
+                const __m128i *v = (const __m128i *)(in + k);
+                __m128i a = _mm_and_si128(_mm_loadu_si128(v),     low);
+                __m128i b = _mm_and_si128(_mm_loadu_si128(v + 1), low);
+                __m128i c = _mm_and_si128(_mm_loadu_si128(v + 2), low);
+                __m128i d = _mm_and_si128(_mm_loadu_si128(v + 3), low);
+                _mm_storeu_si128((__m128i *)(out + k),
+                                 _mm_packus_epi16(_mm_packs_epi32(a, b),
+                                                  _mm_packs_epi32(c, d)));
+        }
+        return k;
+}
+
+/* unsigned samples to big-endian 16-bit: SSE2 packs signed, so the
+ * samples are offset by 0x8000 around the pack
+ */
+__attribute__((target("sse2")))
+static int encode_wide16_sse2(const unsigned *in, uint8_t *out, int n)
+{
+        const __m128i low  = _mm_set1_epi32(0xffff);
+        const __m128i bias = _mm_set1_epi32(0x8000);
+        const __m128i flip = _mm_set1_epi16((short)0x8000);
+        int k = 0;
+        for (; k + 8 <= n; k += 8) {
+                const __m128i *v = (const __m128i *)(in + k);
+                __m128i a = _mm_sub_epi32(_mm_and_si128(_mm_loadu_si128(v),
+                                                        low), bias);
+                __m128i b = _mm_sub_epi32(_mm_and_si128(
+                                _mm_loadu_si128(v + 1), low), bias);
+                __m128i w = _mm_xor_si128(_mm_packs_epi32(a, b), flip);
+                w = _mm_or_si128(_mm_slli_epi16(w, 8), _mm_srli_epi16(w, 8));
+                _mm_storeu_si128((__m128i *)(out + 2 * k), w);
+        }
+        return k;
+}
+#endif
+
+/********** encode_row ********
+ *
+ * The inverse of decode_row, for every format including the wide one
+ *
+ * Notes:
+ *      - a vector encoder (SSE2, or SSSE3 for the shuffles) takes the
+ *        bulk of the row where the CPU has it; the loops below finish
+ *        the row, or do all of it elsewhere
+ *      - struct Pnm_rgb is taken as 3 consecutive unsigneds
+ ************************/
+static void encode_row(Pixfmt fmt, const char *in, int width, uint8_t *out,
+                       int bytes)
+{
+        const int n = 3 * width;
+        const uint8_t  *i8  = (const uint8_t *)in;
+        const uint16_t *i16 = (const uint16_t *)in;
+        const unsigned *iw  = (const unsigned *)in;
+        int k = 0;              /* pixels or samples done by a vector loop */
+
+        if ((fmt == PIXFMT_RGB8 && bytes == 1)
+            || (fmt == PIXFMT_RGB16BE && bytes == 2)) {
+                memcpy(out, in, (size_t)n * bytes);
+        } else if (fmt == PIXFMT_RGBX8 && bytes == 1) {
+#ifdef PPMIO_X86
+                if (__builtin_cpu_supports("ssse3"))
+                        k = encode_rgbx8_ssse3(i8, out, width);
+#endif
+                for (; k < width; k++) {
+                        out[3 * k]     = i8[4 * k];
+                        out[3 * k + 1] = i8[4 * k + 1];
+                        out[3 * k + 2] = i8[4 * k + 2];
+                }
+        } else if (fmt == PIXFMT_RGB16 && bytes == 2) {
+#ifdef PPMIO_X86
+                if (__builtin_cpu_supports("sse2"))
+                        k = encode_rgb16_sse2(i16, out, n);
+#endif
+                for (; k < n; k++) {
+                        out[2 * k]     = i16[k] >> 8;
+                        out[2 * k + 1] = i16[k] & 0xff;
+                }
+        } else if (fmt == PIXFMT_RGBX16 && bytes == 2) {
+#ifdef PPMIO_X86
+                if (__builtin_cpu_supports("ssse3"))
+                        k = encode_rgbx16_ssse3(i16, out, width);
+#endif
+                for (; k < width; k++) {
+                        for (int c = 0; c < 3; c++) {
+                                out[6 * k + 2 * c]     = i16[4 * k + c] >> 8;
+                                out[6 * k + 2 * c + 1] = i16[4 * k + c]
+                                                         & 0xff;
+                        }
+                }
+        } else if (fmt == PIXFMT_WIDE) {
+#ifdef PPMIO_X86
+                if (__builtin_cpu_supports("sse2"))
+                        k = bytes == 1 ? encode_wide8_sse2(iw, out, n)
+                                       : encode_wide16_sse2(iw, out, n);
+#endif
+                for (; k < n; k++) {
+                        if (bytes == 2)
+                                out[2 * k] = iw[k] >> 8 & 0xff;
+                        out[bytes * k + bytes - 1] = iw[k] & 0xff;
+                }
+        } else {
+                const int size = Pixfmt_size(fmt);
+                for (; k < width; k++) {
+                        struct Pnm_rgb rgb;
+                        Pixfmt_unpack(fmt, in + (size_t)k * size, &rgb);
+                        unsigned v[3] = { rgb.red, rgb.green, rgb.blue };
+                        for (int c = 0; c < 3; c++) {
+                                if (bytes == 2)
+                                        *out++ = v[c] >> 8;
+                                *out++ = v[c] & 0xff;
+                        }
+                }
+        }
+}
+
+/*
+ * Planar images: each raw row is scattered into the rows of three
+ * planes (red, green, blue) of samples of the raw width, 16-bit ones
+ * in host order, and gathered back out of them.
+ */
+
+#ifdef PPMIO_X86
+/* shuffles taking the three 16-byte thirds of 16 RGB8 pixels to the 16
+ * samples of each plane: deinterleave[c][q] picks plane c's bytes out
+ * of third q; interleave[q][c] puts plane c's into third q
+ */
+static const int8_t deinterleave[3][3][16] = {
+        { {  0,  3,  6,  9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+          { -1, -1, -1, -1, -1, -1,  2,  5,  8, 11, 14, -1, -1, -1, -1, -1 },
+          { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1,  4,  7, 10, 13 } },
+        { {  1,  4,  7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+          { -1, -1, -1, -1, -1,  0,  3,  6,  9, 12, 15, -1, -1, -1, -1, -1 },
+          { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  2,  5,  8, 11, 14 } },
+        { {  2,  5,  8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+          { -1, -1, -1, -1, -1,  1,  4,  7, 10, 13, -1, -1, -1, -1, -1, -1 },
+          { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  3,  6,  9, 12, 15 } }
+};
+static const int8_t interleave[3][3][16] = {
+        { {  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1,  5 },
+          { -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1 },
+          { -1, -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1 } },
+        { { -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10, -1 },
+          {  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10 },
+          { -1,  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1 } },
+        { { -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 },
+          { -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 },
+          { 10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15 } }
+};
+
+static inline __m128i mask(const int8_t m[16])
+{
+        return _mm_loadu_si128((const __m128i *)m);
+}
+
+/* RGB8 to three byte planes: 16 pixels per nine shuffles */
+__attribute__((target("ssse3")))
+static int decode_planes8_ssse3(const uint8_t *in, uint8_t *const out[3],
+                                int width)
+{
+        int k = 0;
+        for (; k + 16 <= width; k += 16, in += 48) {
+                __m128i third[3];
+                for (int q = 0; q < 3; q++)
+                        third[q] = _mm_loadu_si128((const __m128i *)in + q);
+                for (int c = 0; c < 3; c++) {
+                        __m128i v = _mm_or_si128(
+                                _mm_or_si128(_mm_shuffle_epi8(third[0],
+                                                mask(deinterleave[c][0])),
+                                             _mm_shuffle_epi8(third[1],
+                                                mask(deinterleave[c][1]))),
+                                _mm_shuffle_epi8(third[2],
+                                                 mask(deinterleave[c][2])));
+                        _mm_storeu_si128((__m128i *)(out[c] + k), v);
+                }
+        }
+        return k;
+}
+
+/* three byte planes to RGB8: the inverse */
+__attribute__((target("ssse3")))
+static int encode_planes8_ssse3(const uint8_t *const in[3], uint8_t *out,
+                                int width)
+{
+        int k = 0;
+        for (; k + 16 <= width; k += 16, out += 48) {
+                __m128i plane[3];
+                for (int c = 0; c < 3; c++)
+                        plane[c] = _mm_loadu_si128((const __m128i *)(in[c]
+                                                                     + k));
+                for (int q = 0; q < 3; q++) {
+                        __m128i v = _mm_or_si128(
+                                _mm_or_si128(_mm_shuffle_epi8(plane[0],
+                                                mask(interleave[q][0])),
+                                             _mm_shuffle_epi8(plane[1],
+                                                mask(interleave[q][1]))),
+                                _mm_shuffle_epi8(plane[2],
+                                                 mask(interleave[q][2])));
+                        _mm_storeu_si128((__m128i *)out + q, v);
+                }
+        }
+        return k;
+}
+#endif
+
+/********** decode_planes ********
+ *
+ * Scatters 'width' raw pixels from 'in' (samples of 'bytes' bytes,
+ * big-endian) into the rows 'out[0..2]' of the red, green and blue
+ * planes, whose samples are 'bytes' bytes too
+ ************************/
+static void decode_planes(const uint8_t *in, int bytes, char *const out[3],
+                          int width)
+{
+        int k = 0;
+        if (bytes == 1) {
+                uint8_t *const o8[3] = { (uint8_t *)out[0],
+                                         (uint8_t *)out[1],
+                                         (uint8_t *)out[2] };
+#ifdef PPMIO_X86
+                if (__builtin_cpu_supports("ssse3"))
+                        k = decode_planes8_ssse3(in, o8, width);
+#endif
+                for (in += 3 * k; k < width; k++, in += 3) {
+                        o8[0][k] = in[0];
+                        o8[1][k] = in[1];
+                        o8[2][k] = in[2];
+                }
+        } else {
+                uint16_t *const o16[3] = { (uint16_t *)out[0],
+                                           (uint16_t *)out[1],
+                                           (uint16_t *)out[2] };
+                for (; k < width; k++, in += 6) {
+                        o16[0][k] = (uint16_t)(in[0] << 8 | in[1]);
+                        o16[1][k] = (uint16_t)(in[2] << 8 | in[3]);
+                        o16[2][k] = (uint16_t)(in[4] << 8 | in[5]);
+                }
+        }
+}
+
+/********** encode_planes ********
+ *
+ * The inverse of decode_planes: gathers 'width' pixels from the plane
+ * rows 'in[0..2]' into raw samples of 'bytes' bytes at 'out'
+ ************************/
+static void encode_planes(const char *const in[3], int width, uint8_t *out,
+                          int bytes)
+{
+        int k = 0;
+        if (bytes == 1) {
+                const uint8_t *const i8[3] = { (const uint8_t *)in[0],
+                                               (const uint8_t *)in[1],
+                                               (const uint8_t *)in[2] };
+#ifdef PPMIO_X86
+                if (__builtin_cpu_supports("ssse3"))
+                        k = encode_planes8_ssse3(i8, out, width);
+#endif
+                for (out += 3 * k; k < width; k++, out += 3) {
+                        out[0] = i8[0][k];
+                        out[1] = i8[1][k];
+                        out[2] = i8[2][k];
+                }
+        } else {
+                const uint16_t *const i16[3] = { (const uint16_t *)in[0],
+                                                 (const uint16_t *)in[1],
+                                                 (const uint16_t *)in[2] };
+                for (; k < width; k++, out += 6) {
+                        for (int c = 0; c < 3; c++) {
+                                out[2 * c]     = i16[c][k] >> 8;
+                                out[2 * c + 1] = i16[c][k] & 0xff;
+                        }
+                }
+        }
+}
+
+/*
+ * The arrays an image is read into or written from, a row at a time:
+ * one array of cells in 'fmt', or the three planes of a planar image.
+ */
+struct cells {
+        Pixfmt      fmt;                /* unless planar */
+        int         nplanes;            /* 1, or 3 if planar */
+        int         width;
+        struct rows plane[3];           /* only plane[0] unless planar */
+};
+
+static struct cells cells_new(const struct A2Methods_T *methods,
+                              A2Methods_UArray2 *arrays, int nplanes,
+                              Pixfmt fmt)
+{
+        struct cells c;
+        c.fmt     = fmt;
+        c.nplanes = nplanes;
+        for (int p = 0; p < nplanes; p++)
+                c.plane[p] = rows_new(methods, arrays[p]);
+        c.width   = c.plane[0].width;
+        return c;
+}
+
+/* decodes the raw row 'raster' into row 'row' of the arrays */
+static void cells_put(struct cells *c, int row, const uint8_t *raster,
+                      int bytes)
+{
+        if (c->nplanes == 1) {
+                decode_row(c->fmt, raster, bytes,
+                           rows_buffer(&c->plane[0], row), c->width);
+        } else {
+                char *out[3];
+                for (int p = 0; p < 3; p++)
+                        out[p] = rows_buffer(&c->plane[p], row);
+                decode_planes(raster, bytes, out, c->width);
+        }
+        for (int p = 0; p < c->nplanes; p++)
+                rows_put(&c->plane[p], row);
+}
+
+/* encodes row 'row' of the arrays as a raw row at 'out'; rows must be
+ * asked for in order (see rows_get)
+ */
+static void cells_get(struct cells *c, int row, uint8_t *out, int bytes)
+{
+        if (c->nplanes == 1) {
+                encode_row(c->fmt, rows_get(&c->plane[0], row), c->width,
+                           out, bytes);
+        } else {
+                const char *in[3];
+                for (int p = 0; p < 3; p++)
+                        in[p] = rows_get(&c->plane[p], row);
+                encode_planes(in, c->width, out, bytes);
+        }
+}
+
+static void cells_free(struct cells *c)
+{
+        for (int p = 0; p < c->nplanes; p++)
+                rows_free(&c->plane[p]);
+}
+
+/*
+ * Plain (P3) rasters are read TEXT_CHUNK bytes at a time and scanned in
+ * windows of 64 bytes.  Each window is classified at once into bit
+ * masks of digits, '#' and other non-space bytes (SSE2 where there is
+ * SSE2); the digit runs fall out of the masks, and each run of up to
+ * eight digits is converted with a few multiplies on one 64-bit word.
+ */
+enum { TEXT_CHUNK = 1 << 16, WINDOW = 64, SLACK = 8 };
+
+/* where the parsed samples go: a raw row, decoded into the cells as it
+ * fills */
+struct plain_raster {
+        struct cells *cells;
+        unsigned      denominator;
+        int           bytes;            /* of a raw sample */
+        uint8_t      *raster;           /* one raw row */
+        size_t        samples, filled;  /* per row, and so far */
+        unsigned      row, height;
+};
+
+/********** put_sample ********
+ *
+ * Appends sample 'v' to the current row, storing the row once it is
+ * full; false if 'v' is over the denominator
+ ************************/
+static inline bool put_sample(struct plain_raster *p, uint64_t v)
+{
+        if (v > p->denominator || p->row == p->height)
+                return p->row == p->height;     /* trailing text is fine */
+        if (p->bytes == 1) {
+                p->raster[p->filled] = v;
+        } else {
+                p->raster[2 * p->filled]     = v >> 8;
+                p->raster[2 * p->filled + 1] = v & 0xff;
+        }
+        if (++p->filled == p->samples) {
+                cells_put(p->cells, p->row, p->raster, p->bytes);
+                p->filled = 0;
+                p->row++;
+        }
+        return true;
+}
+
+/********** digits_value ********
+ *
+ * The value of the 'n' decimal digits ending just before 'end'
+ *
+ * Notes:
+ *      - up to eight digits are one unaligned load of the eight bytes
+ *        before 'end' (SLACK bytes before the text keep it in bounds);
+ *        the bytes before the number are masked to leading zeros and
+ *        digit pairs, quads and octets are combined by multiplies
+ ************************/
+static inline uint64_t digits_value(const uint8_t *end, int n)
+{
+        if (n > 8) {                            /* leading zeros, or junk */
+                uint64_t v = 0;
+                for (const uint8_t *d = end - n; d < end; d++) {
+                        v = v * 10 + (*d - '0');
+                        if (v > 65535)
+                                return v;
+                }
+                return v;
+        }
+        uint64_t v;
+        memcpy(&v, end - 8, 8);
+        uint64_t keep = ~0ull << (8 * (8 - n));
+        v = (v & keep & 0x0f0f0f0f0f0f0f0full);
+        v = (v * 2561) >> 8;
+        v = ((v & 0x00ff00ff00ff00ffull) * 6553601) >> 16;
+        return ((v & 0x0000ffff0000ffffull) * 42949672960001ull) >> 32;
+}
+
+/********** classify ********
+ *
+ * Sets bit k of '*digits', '*hash' and '*bad' when byte p[k] of the
+ * 64 is a digit, a '#', or neither of those nor whitespace
+ ************************/
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+static inline void classify(const uint8_t *p, uint64_t *digits,
+                            uint64_t *hash, uint64_t *bad)
+{
+        const __m128i zero = _mm_set1_epi8('0'), nine = _mm_set1_epi8(9);
+        const __m128i tab = _mm_set1_epi8('\t'), four = _mm_set1_epi8(4);
+        const __m128i space = _mm_set1_epi8(' '), pound = _mm_set1_epi8('#');
+        uint64_t d = 0, h = 0, ok = 0;
+
+        for (int q = 0; q < 4; q++) {
+                __m128i x = _mm_loadu_si128((const __m128i *)(p + 16 * q));
+                __m128i t = _mm_sub_epi8(x, zero);      /* '0'..'9' -> 0..9 */
+                __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(t, nine), t);
+                __m128i u = _mm_sub_epi8(x, tab);       /* \t..\r -> 0..4 */
+                __m128i is_space = _mm_or_si128(
+                        _mm_cmpeq_epi8(_mm_min_epu8(u, four), u),
+                        _mm_cmpeq_epi8(x, space));
+                __m128i is_hash = _mm_cmpeq_epi8(x, pound);
+
+                d  |= (uint64_t)(unsigned)_mm_movemask_epi8(is_digit)
+                      << (16 * q);
+                h  |= (uint64_t)(unsigned)_mm_movemask_epi8(is_hash)
+                      << (16 * q);
+                ok |= (uint64_t)(unsigned)_mm_movemask_epi8(
+                        _mm_or_si128(_mm_or_si128(is_digit, is_space),
+                                     is_hash)) << (16 * q);
+        }
+        *digits = d;
+        *hash   = h;
+        *bad    = ~ok;
+}
+#else
+static inline void classify(const uint8_t *p, uint64_t *digits,
+                            uint64_t *hash, uint64_t *bad)
+{
+        uint64_t d = 0, h = 0, b = 0;
+        for (int k = 0; k < WINDOW; k++) {
+                uint64_t bit = 1ull << k;
+                if (isdigit(p[k]))
+                        d |= bit;
+                else if (p[k] == '#')
+                        h |= bit;
+                else if (!isspace(p[k]))
+                        b |= bit;
+        }
+        *digits = d;
+        *hash   = h;
+        *bad    = b;
+}
+#endif
+
+/********** parse_text ********
+ *
+ * Parses text[0, limit), which ends outside any number and is followed
+ * by WINDOW + 1 spaces, into samples; '*comment' says whether the text
+ * starts (and is left) inside a comment.  False on a bad sample, or a
+ * bad byte before the last sample.
+ ************************/
+static bool parse_text(struct plain_raster *p, const uint8_t *text,
+                       size_t limit, bool *comment)
+{
+        size_t pos = 0;
+        if (*comment) {
+                const uint8_t *nl = memchr(text, '\n', limit);
+                if (nl == NULL)
+                        return true;
+                *comment = false;
+                pos = nl + 1 - text;
+        }
+
+        uint64_t carry = 0;             /* window ended inside a number */
+        size_t first = 0;               /* where that number starts */
+        while (pos < limit) {
+                uint64_t d, h, bad;
+                classify(text + pos, &d, &h, &bad);
+                int stop = WINDOW;      /* a '#' or bad byte ends it */
+                if ((h | bad) != 0) {
+                        stop = __builtin_ctzll(h | bad);
+                        d &= (1ull << stop) - 1;
+                }
+
+                uint64_t next = stop == WINDOW && isdigit(text[pos + WINDOW]);
+                uint64_t ends   = d & ~((d >> 1) | (next << 63));
+                uint64_t starts = d & ~((d << 1) | carry);
+
+                while (ends != 0) {
+                        int e = __builtin_ctzll(ends);
+                        ends &= ends - 1;
+                        size_t s = first;
+                        if (carry) {
+                                carry = 0;
+                        } else {
+                                s = pos + __builtin_ctzll(starts);
+                                starts &= starts - 1;
+                        }
+                        size_t end = pos + e + 1;
+                        if (!put_sample(p, digits_value(text + end,
+                                                        end - s)))
+                                return false;
+                }
+                if (starts != 0) {              /* runs into next window */
+                        first = pos + __builtin_ctzll(starts);
+                        carry = 1;
+                }
+
+                if (p->row == p->height)        /* the rest is ignored */
+                        return true;
+                if (stop < WINDOW && text[pos + stop] != '#')
+                        return false;
+                if (stop < WINDOW) {            /* skip the comment */
+                        const uint8_t *hash = text + pos + stop;
+                        const uint8_t *nl = memchr(hash, '\n',
+                                                   text + limit - hash);
+                        if (nl == NULL) {
+                                *comment = true;
+                                return true;
+                        }
+                        pos = nl + 1 - text;
+                } else {
+                        pos += WINDOW;
+                }
+        }
+        return true;
+}
+
+/********** read_plain_raster ********
+ *
+ * Parses the samples of a plain (P3) file after the header into the
+ * rows of 'p'; false on a bad byte or sample or too few samples
+ *
+ * Notes:
+ *      - each chunk is cut after its last non-digit, so no number is
+ *        split; the cut-off digits start the next chunk
+ ************************/
+static bool read_plain_raster(FILE *fp, struct plain_raster *p)
+{
+        uint8_t *buffer = malloc(SLACK + TEXT_CHUNK + WINDOW + 1);
+        assert(buffer != NULL);
+        uint8_t *text = buffer + SLACK;
+        uint8_t tail[WINDOW];
+        size_t have = 0;
+        bool comment = false, ok = true, eof = false;
+
+        memset(buffer, ' ', SLACK);
+        while (ok && !eof && p->row < p->height) {
+                size_t got = fread(text + have, 1, TEXT_CHUNK - have, fp);
+                size_t len = have + got;
+                eof = got < TEXT_CHUNK - have;
+
+                size_t limit = len;
+                if (!eof) {
+                        while (limit > 0 && isdigit(text[limit - 1]))
+                                limit--;
+                }
+                have = len - limit;
+                if (have > sizeof(tail)) {      /* a 64-digit number */
+                        ok = false;
+                        break;
+                }
+                memcpy(tail, text + limit, have);
+                memset(text + limit, ' ', WINDOW + 1);
+
+                ok = parse_text(p, text, limit, &comment);
+                memcpy(text, tail, have);
+        }
+        free(buffer);
+        return ok && p->row == p->height;
+}
+
+/********** read_image ********
+ *
+ * Reads a P6 or P3 file from 'fp' into cells of '*fmt', which is set to
+ * PIXFMT_WIDE if 'wide' and to the compact format for the denominator
+ * otherwise, or into three planes
+ *
+ * Parameters:
+ *      FILE *fp:            open input, positioned at the magic number
+ *      A2Methods_T methods: suite for the new pixel arrays
+ *      bool wide:           struct Pnm_rgb cells, as Pnm_ppmread makes
+ *      bool aligned:        4- or 8-byte pixels rather than 3 or 6
+ *      Pixfmt *fmt:         where to store the format chosen
+ *      A2Methods_UArray2 *planes: NULL, or where to store the red,
+ *                           green and blue planes of a planar image;
+ *                           planes[0] is also the image's pixels
+ *
+ * Return:
+ *      the image, or NULL if 'fp' does not hold a whole PPM
+ *
+ * Notes:
+ *      - raw rows are read with one fread each into a byte buffer and
+ *        decoded into the row of the array (plain), a band of rows
+ *        (blocked, see struct rows) or a scratch row; a planar row is
+ *        scattered into the same row of each plane
+ *      - plain rows are parsed into the same raw form first; see
+ *        read_plain_raster
+ ************************/
+static Pnm_ppm read_image(FILE *fp, A2Methods_T methods, bool wide,
+                          bool aligned, Pixfmt *fmt,
+                          A2Methods_UArray2 *planes)
+{
+        assert(fp != NULL && methods != NULL && fmt != NULL);
+
+        unsigned width, height, denominator;
+        bool raw;
+        if (!read_header(fp, &raw, &width, &height, &denominator))
+                return NULL;
+
+        Pnm_ppm image = malloc(sizeof(*image));
+        assert(image != NULL);
+        *fmt = wide ? PIXFMT_WIDE : Pixfmt_packed(denominator, aligned);
+        image->width       = width;
+        image->height      = height;
+        image->denominator = denominator;
+        image->methods     = methods;
+
+        const int nplanes = planes != NULL ? 3 : 1;
+        const int size = planes != NULL ? Pixfmt_plane_size(denominator)
+                                        : Pixfmt_size(*fmt);
+        A2Methods_UArray2 arrays[3];
+        for (int p = 0; p < nplanes; p++)
+                arrays[p] = methods->new(width, height, size);
+        image->pixels = arrays[0];
+
+        const int bytes = denominator > 255 ? 2 : 1;
+        const size_t row_bytes = (size_t)3 * bytes * width;
+        uint8_t *raster = malloc(row_bytes);
+        assert(raster != NULL);
+        struct cells c = cells_new(methods, arrays, nplanes, *fmt);
+        bool ok = true;
+
+        if (raw) {
+                for (unsigned row = 0; ok && row < height; row++) {
+                        ok = fread(raster, 1, row_bytes, fp) == row_bytes;
+                        if (ok)
+                                cells_put(&c, row, raster, bytes);
+                }
+        } else {
+                struct plain_raster p;
+                p.cells       = &c;
+                p.denominator = denominator;
+                p.bytes       = bytes;
+                p.raster      = raster;
+                p.samples     = (size_t)3 * width;
+                p.filled      = 0;
+                p.row         = 0;
+                p.height      = height;
+                ok = read_plain_raster(fp, &p);
+        }
+
+        cells_free(&c);
+        free(raster);
+        if (!ok) {
+                for (int p = 1; p < nplanes; p++)
+                        methods->free(&arrays[p]);
+                Pnm_ppmfree(&image);
+                return NULL;
+        }
+        for (int p = 0; planes != NULL && p < nplanes; p++)
+                planes[p] = arrays[p];
+        return image;
+}
+
+Pnm_ppm Ppmio_read(FILE *fp, A2Methods_T methods, bool aligned, Pixfmt *fmt)
+{
+        return read_image(fp, methods, false, aligned, fmt, NULL);
+}
+
+Pnm_ppm Ppmio_read_wide(FILE *fp, A2Methods_T methods)
+{
+        Pixfmt fmt;
+        return read_image(fp, methods, true, false, &fmt, NULL);
+}
+
+Pnm_ppm Ppmio_read_planes(FILE *fp, A2Methods_T methods,
+                          A2Methods_UArray2 planes[3])
+{
+        assert(planes != NULL);
+        Pixfmt fmt;
+        return read_image(fp, methods, false, false, &fmt, planes);
+}
+
+/*
+ * Output is encoded into a page-aligned buffer of OUT_BUFFER bytes and
+ * goes out a buffer at a time; rows already in raw form go out by
+ * writev, up to IOV_BATCH runs per call.
+ */
+enum { OUT_BUFFER = 1 << 20, PAGE = 4096, IOV_BATCH = 512 };
+
+/********** write_iov ********
+ *
+ * Writes all of 'iov[0..n-1]' to 'fd', picking up after short writes
+ * and interrupts; false on an error.  'iov' is used up.
+ ************************/
+static bool write_iov(int fd, struct iovec *iov, int n)
+{
+        while (n > 0) {
+                ssize_t done = writev(fd, iov, n);
+                if (done < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        return false;
+                }
+                while (n > 0 && (size_t)done >= iov->iov_len) {
+                        done -= iov->iov_len;
+                        iov++;
+                        n--;
+                }
+                if (n > 0) {
+                        iov->iov_base = (char *)iov->iov_base + done;
+                        iov->iov_len -= done;
+                }
+        }
+        return true;
+}
+
+/* the header Pnm_ppmwrite gives 'image'; returns its length */
+static int format_header(char *header, size_t n, Pnm_ppm image)
+{
+        return snprintf(header, n, "P6\n%u %u\n%u\n", image->width,
+                        image->height, image->denominator);
+}
+
+/* true if the rows of cells of 'image', in 'fmt', are raw rows */
+static bool raw_cells(Pnm_ppm image, Pixfmt fmt)
+{
+        const int bytes = image->denominator > 255 ? 2 : 1;
+        return image->methods == uarray2_methods_plain
+               && ((fmt == PIXFMT_RGB8 && bytes == 1)
+                   || (fmt == PIXFMT_RGB16BE && bytes == 2));
+}
+
+/********** write_cells ********
+ *
+ * Writes 'header' and then the rows of 'image' straight out of the
+ * array, with rows that lie end to end merged into one run; only for
+ * images whose cells are raw rows (see raw_cells)
+ ************************/
+static bool write_cells(int fd, Pnm_ppm image, char *header,
+                        int header_length)
+{
+        const size_t row_bytes = (size_t)image->width
+                                 * image->methods->size(image->pixels);
+        struct iovec iov[IOV_BATCH];
+        int n = 1;
+        iov[0].iov_base = header;
+        iov[0].iov_len  = header_length;
+
+        for (unsigned row = 0; row < image->height; row++) {
+                char *cells = image->methods->at(image->pixels, 0, row);
+                struct iovec *last = &iov[n - 1];
+                if (n > 1 && (char *)last->iov_base + last->iov_len
+                             == cells) {
+                        last->iov_len += row_bytes;
+                        continue;
+                }
+                if (n == IOV_BATCH) {
+                        if (!write_iov(fd, iov, n))
+                                return false;
+                        n = 0;
+                }
+                iov[n].iov_base = cells;
+                iov[n].iov_len  = row_bytes;
+                n++;
+        }
+        return write_iov(fd, iov, n);
+}
+
+/********** write_rows ********
+ *
+ * Writes the image with the header of 'image' and the rows of 'c' as a
+ * raw PPM to the file descriptor under 'fp'
+ *
+ * Notes:
+ *      - rows are gathered (a band at a time from blocks; see struct
+ *        rows) and encoded into a buffer of OUT_BUFFER bytes, which is
+ *        written with one call when full
+ *      - plain arrays of RGB8 or RGB16BE cells already hold the raster,
+ *        and are written from in place with writev
+ *      - whatever 'fp' has buffered is flushed first; the image itself
+ *        does not go through stdio
+ ************************/
+static bool write_rows(FILE *fp, Pnm_ppm image, struct cells *c)
+{
+        char header[64];
+        const int header_length = format_header(header, sizeof(header),
+                                                image);
+        const int fd = fileno(fp);
+        if (fflush(fp) != 0)
+                return false;
+        if (c->nplanes == 1 && raw_cells(image, c->fmt))
+                return write_cells(fd, image, header, header_length);
+
+        const int bytes = image->denominator > 255 ? 2 : 1;
+        const size_t row_bytes = (size_t)3 * bytes * image->width;
+        const size_t capacity = row_bytes + header_length > OUT_BUFFER
+                                ? row_bytes + header_length : OUT_BUFFER;
+        void *buffer = NULL;
+        if (posix_memalign(&buffer, PAGE, capacity) != 0)
+                buffer = NULL;
+        assert(buffer != NULL);
+        uint8_t *out = buffer;
+
+        memcpy(out, header, header_length);
+        size_t used = header_length;
+        bool ok = true;
+        for (unsigned row = 0; ok && row < image->height; row++) {
+                if (used + row_bytes > capacity) {
+                        struct iovec full = { out, used };
+                        ok = write_iov(fd, &full, 1);
+                        used = 0;
+                }
+                cells_get(c, row, out + used, bytes);
+                used += row_bytes;
+        }
+        struct iovec rest = { out, used };
+        ok = ok && write_iov(fd, &rest, 1);
+
+        free(buffer);
+        return ok;
+}
+
+/********** map_rows ********
+ *
+ * Writes the image with the header of 'image' and the rows of 'c' as a
+ * raw PPM into the file 'path', created or truncated, by mapping the
+ * file and encoding each row in place
+ *
+ * Return:
+ *      false if the file cannot be created, sized or mapped
+ *
+ * Notes:
+ *      - the file's blocks are allocated before it is mapped, so a
+ *        full disk is an error here rather than a SIGBUS later
+ ************************/
+static bool map_rows(const char *path, Pnm_ppm image, struct cells *c)
+{
+        char header[64];
+        const int header_length = format_header(header, sizeof(header),
+                                                image);
+        const int bytes = image->denominator > 255 ? 2 : 1;
+        const size_t row_bytes = (size_t)3 * bytes * image->width;
+        const size_t length = header_length + row_bytes * image->height;
+
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0)
+                return false;
+        if (posix_fallocate(fd, 0, length) != 0) {
+                close(fd);
+                return false;
+        }
+        uint8_t *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                            fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+                return false;
+
+        memcpy(map, header, header_length);
+        uint8_t *out = map + header_length;
+        for (unsigned row = 0; row < image->height; row++, out += row_bytes)
+                cells_get(c, row, out, bytes);
+
+        return munmap(map, length) == 0;
+}
+
+/* the planes of a planar image with the header of 'image', as cells */
+static struct cells plane_cells(Pnm_ppm image, A2Methods_UArray2 planes[3])
+{
+        assert(image != NULL && planes != NULL);
+        const int size = Pixfmt_plane_size(image->denominator);
+        for (int p = 0; p < 3; p++) {
+                assert(image->methods->size(planes[p]) == size);
+                assert(image->methods->width(planes[p])
+                       == (int)image->width);
+                assert(image->methods->height(planes[p])
+                       == (int)image->height);
+        }
+        return cells_new(image->methods, planes, 3, PIXFMT_WIDE);
+}
+
+bool Ppmio_write(FILE *fp, Pnm_ppm image, Pixfmt fmt)
+{
+        assert(fp != NULL && image != NULL);
+        assert(image->methods->size(image->pixels) == Pixfmt_size(fmt));
+        struct cells c = cells_new(image->methods, &image->pixels, 1, fmt);
+        bool ok = write_rows(fp, image, &c);
+        cells_free(&c);
+        return ok;
+}
+
+bool Ppmio_write_map(const char *path, Pnm_ppm image, Pixfmt fmt)
+{
+        assert(path != NULL && image != NULL);
+        assert(image->methods->size(image->pixels) == Pixfmt_size(fmt));
+        struct cells c = cells_new(image->methods, &image->pixels, 1, fmt);
+        bool ok = map_rows(path, image, &c);
+        cells_free(&c);
+        return ok;
+}
+
+bool Ppmio_write_planes(FILE *fp, Pnm_ppm image, A2Methods_UArray2 planes[3])
+{
+        assert(fp != NULL);
+        struct cells c = plane_cells(image, planes);
+        bool ok = write_rows(fp, image, &c);
+        cells_free(&c);
+        return ok;
+}
+
+bool Ppmio_write_planes_map(const char *path, Pnm_ppm image,
+                            A2Methods_UArray2 planes[3])
+{
+        assert(path != NULL);
+        struct cells c = plane_cells(image, planes);
+        bool ok = map_rows(path, image, &c);
+        cells_free(&c);
+        return ok;
+}
+
+/* a mapped image: the Pnm_ppm handed out, and the mapping behind it */
+struct mapped {
+        struct Pnm_ppm ppm;             /* first, so a Pnm_ppm converts */
+        void          *map;
+        size_t         length;
+};
+
+/********** Ppmio_map ********
+ *
+ * Maps a raw PPM file and wraps its raster in a plain array without
+ * copying a byte
+ *
+ * Parameters:
+ *      const char *path: the file
+ *      Pixfmt *fmt:      where to store the format of the cells
+ *
+ * Return:
+ *      the image, or NULL if 'path' cannot be mapped or is not a whole
+ *      raw PPM
+ *
+ * Notes:
+ *      - the header is parsed by read_header over the mapping, opened
+ *        with fmemopen, so both readers accept the same headers
+ *      - the mapping is read-only: a store into the pixels faults
+ *      - MADV_WILLNEED starts reading a cold file ahead of the
+ *        transform; pages already cached are used in place
+ ************************/
+Pnm_ppm Ppmio_map(const char *path, Pixfmt *fmt)
+{
+        assert(path != NULL && fmt != NULL);
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+                return NULL;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+                close(fd);
+                return NULL;
+        }
+        size_t length = st.st_size;
+        void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+                return NULL;
+
+        unsigned width, height, denominator;
+        bool raw = false, ok;
+        FILE *header = fmemopen(map, length, "r");
+        ok = header != NULL
+             && read_header(header, &raw, &width, &height, &denominator)
+             && raw;
+        size_t offset = ok ? (size_t)ftell(header) : 0;
+        if (header != NULL)
+                fclose(header);
+
+        const int bytes = ok && denominator > 255 ? 2 : 1;
+        if (!ok || (size_t)3 * bytes * width * height > length - offset) {
+                munmap(map, length);
+                return NULL;
+        }
+        madvise(map, length, MADV_WILLNEED);
+
+        struct mapped *m = malloc(sizeof(*m));
+        assert(m != NULL);
+        *fmt = bytes == 2 ? PIXFMT_RGB16BE : PIXFMT_RGB8;
+        m->map    = map;
+        m->length = length;
+        m->ppm.width       = width;
+        m->ppm.height      = height;
+        m->ppm.denominator = denominator;
+        m->ppm.methods     = uarray2_methods_plain;
+        m->ppm.pixels      = UArray2_view(width, height, Pixfmt_size(*fmt),
+                                          (char *)map + offset);
+        return &m->ppm;
+}
+
+void Ppmio_unmap(Pnm_ppm *image)
+{
+        assert(image != NULL && *image != NULL);
+        struct mapped *m = (struct mapped *)*image;
+        m->ppm.methods->free(&m->ppm.pixels);
+        munmap(m->map, m->length);
+        free(m);
+        *image = NULL;
+}
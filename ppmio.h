@@ -0,0 +1,79 @@
+#ifndef PPMIO_INCLUDED
+#define PPMIO_INCLUDED
+
+/*
+ * A PPM reader and writer that work in the compact formats of pixfmt.h,
+ * so that an image never exists as struct Pnm_rgb.  Raw (P6) samples
+ * are read a row at a time and decoded straight into the cells: one
+ * byte per sample, or two big-endian bytes when the denominator is
+ * above 255.  Plain (P3) files are parsed too.  A raw file may instead
+ * be mapped and its raster used in place.  Blocked arrays are filled,
+ * and written out, a row of blocks at a time, in the wide format too.
+ * A planar image goes straight to and from its three planes, never
+ * existing as interleaved pixels.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "a2methods.h"
+#include "pnm.h"
+#include "pixfmt.h"
+
+/*
+ * reads a PPM from 'fp' into a new image whose pixels come from
+ * 'methods', in Pixfmt_packed(denominator, aligned); the format is
+ * stored in '*fmt'.  The image is freed with Pnm_ppmfree.
+ *
+ * returns NULL if 'fp' does not hold a whole PPM
+ */
+extern Pnm_ppm Ppmio_read(FILE *fp, A2Methods_T methods, bool aligned,
+                          Pixfmt *fmt);
+
+/* same, but the pixels are struct Pnm_rgb, as Pnm_ppmread makes them;
+ * for a blocked suite this fills whole blocks rather than a cell at a
+ * time
+ */
+extern Pnm_ppm Ppmio_read_wide(FILE *fp, A2Methods_T methods);
+
+/* same, but into three new arrays from 'methods' stored in planes[0..2]:
+ * the red, green and blue samples, Pixfmt_plane_size(denominator)
+ * bytes each.  The image's pixels are planes[0], which Pnm_ppmfree
+ * frees; the other two planes are the caller's to free.  On NULL no
+ * planes are left.
+ */
+extern Pnm_ppm Ppmio_read_planes(FILE *fp, A2Methods_T methods,
+                                 A2Methods_UArray2 planes[3]);
+
+/*
+ * maps the raw (P6) PPM file 'path' and returns an image whose pixels
+ * are a read-only plain (uarray2_methods_plain) array over the raster
+ * itself, nothing copied: RGB8 cells, or RGB16BE past a denominator of
+ * 255; the format is stored in '*fmt'.  The image is released with
+ * Ppmio_unmap, not Pnm_ppmfree.
+ *
+ * returns NULL if 'path' is not a regular file holding a whole raw PPM
+ */
+extern Pnm_ppm Ppmio_map(const char *path, Pixfmt *fmt);
+extern void    Ppmio_unmap(Pnm_ppm *image);
+
+/*
+ * writes 'image', whose pixels are in 'fmt' (the wide format included)
+ * and may come from any suite, as a raw PPM with the same header
+ * Pnm_ppmwrite gives.  Ppmio_write_map writes the file 'path' through a
+ * shared mapping instead of a descriptor.
+ *
+ * return false if the output cannot be written
+ */
+extern bool Ppmio_write    (FILE *fp, Pnm_ppm image, Pixfmt fmt);
+extern bool Ppmio_write_map(const char *path, Pnm_ppm image, Pixfmt fmt);
+
+/* same, for a planar image: 'image' gives the header and the suite,
+ * and the samples come from planes[0..2] (as Ppmio_read_planes makes
+ * them), whatever 'image->pixels' is
+ */
+extern bool Ppmio_write_planes    (FILE *fp, Pnm_ppm image,
+                                   A2Methods_UArray2 planes[3]);
+extern bool Ppmio_write_planes_map(const char *path, Pnm_ppm image,
+                                   A2Methods_UArray2 planes[3]);
+
+#endif
@@ -7,8 +7,8 @@
  *     Date:       October 7, 2024
  *
  *     This file contains the implementation of 'ppmtrans', 
- *     which performs image transformations on PPM files, mainly  
- *     rotation using the A2Methods_T interface. 
+ *     which performs image transformations on PPM files (rotations,
+ *     flips and transposes) using the A2Methods_T interface. 
  *
  *
  **************************************************************/
@@ -16,13 +16,20 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <sys/stat.h>
 
 #include "assert.h"
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2morton.h"
+#include "a2hier.h"
 #include "pnm.h"
 #include "cputiming.h"
+#include "cacheinfo.h"
+#include "rotate.h"
+#include "pixfmt.h"
+#include "ppmio.h"
 
 #define SET_METHODS(METHODS, MAP, WHAT) do {                    \
         methods = (METHODS);                                    \
@@ -36,12 +43,22 @@
         }                                                       \
 } while (false)
 
+/* bytes per stored pixel, sizeof(struct Pnm_rgb) unless -format packs
+ * the image (or per sample, if it is planar); the apply_* and span_*
+ * functions copy this much */
+static int pixel_size = sizeof(struct Pnm_rgb);
+
 static void
 usage(const char *progname)
 {
         fprintf(stderr, "Usage: %s [-rotate <angle>] "
-                        "[-{row,col,block}-major] "
-		        "[-time time_file] "
+                        "[-flip {horizontal,vertical}] [-transpose] "
+                        "[-{row,col,block,block-pow2,block-cache,block-line,"
+                        "hier-block,morton}-major] "
+                        "[-hilbert-major] [-spans] [-inline] [-direct] "
+                        "[-cache-oblivious] [-inplace] "
+                        "[-format {wide,packed,aligned,planar}] "
+		        "[-time time_file] [-output file] "
 		        "[filename]\n",
                         progname);
         exit(1);
@@ -55,7 +72,32 @@ void apply_180(int col, int row, A2Methods_UArray2 uarray,
                 void *elem, void *cl);
 void apply_270(int col, int row, A2Methods_UArray2 uarray, 
                 void *elem, void *cl);
+void apply_flip_horizontal(int col, int row, A2Methods_UArray2 uarray,
+                           void *elem, void *cl);
+void apply_flip_vertical(int col, int row, A2Methods_UArray2 uarray,
+                         void *elem, void *cl);
+void apply_transpose(int col, int row, A2Methods_UArray2 uarray,
+                     void *elem, void *cl);
+void apply_transverse(int col, int row, A2Methods_UArray2 uarray,
+                      void *elem, void *cl);
+void span_copy(int col, int row, int length, void *first, int stride,
+               void *cl);
+void span_90(int col, int row, int length, void *first, int stride,
+             void *cl);
+void span_180(int col, int row, int length, void *first, int stride,
+              void *cl);
+void span_270(int col, int row, int length, void *first, int stride,
+              void *cl);
+void span_flip_horizontal(int col, int row, int length, void *first,
+                          int stride, void *cl);
+void span_flip_vertical(int col, int row, int length, void *first,
+                        int stride, void *cl);
+void span_transpose(int col, int row, int length, void *first, int stride,
+                    void *cl);
+void span_transverse(int col, int row, int length, void *first, int stride,
+                     void *cl);
 void free_memory(Pnm_ppm *image, Pnm_ppm *trans_image);
+bool same_file(const char *path, const char *other);
 
 /********** free_memory ********
  *
@@ -84,6 +126,19 @@ void free_memory(Pnm_ppm *image, Pnm_ppm *trans_image)
     }
 }
 
+/********** same_file ********
+ *
+ * Returns true if 'path' and 'other' name the same existing file;
+ * false if either is NULL or missing
+ ************************/
+bool same_file(const char *path, const char *other)
+{
+        struct stat a, b;
+        return path != NULL && other != NULL
+               && stat(path, &a) == 0 && stat(other, &b) == 0
+               && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
 /********** apply_copy ********
  *
  * takes pixel data from original image and copies it into corresponding 
@@ -113,8 +168,7 @@ void apply_copy(int col, int row, A2Methods_UArray2 uarray,
         (void)uarray;
     Pnm_ppm new_image = (Pnm_ppm)cl;
     A2Methods_T methods = (A2Methods_T)new_image->methods;
-    *(struct Pnm_rgb *)methods->at(new_image->pixels, col, row) = 
-        *(struct Pnm_rgb *)elem;
+    memcpy(methods->at(new_image->pixels, col, row), elem, pixel_size);
 }
 
 /********** apply_90 ********
@@ -150,7 +204,7 @@ void apply_90(int col, int row, A2Methods_UArray2 uarray, void *elem, void *cl)
 
     /* access element at rotated position */
     void *new_elem = methods->at(new_image->pixels, new_col, new_row);
-    memcpy(new_elem, elem, sizeof(struct Pnm_rgb));
+    memcpy(new_elem, elem, pixel_size);
 }
 
 /********** apply_180 ********
@@ -188,7 +242,7 @@ void apply_180(int col, int row, A2Methods_UArray2 uarray,
 
     /* access elements in rotated position */
     void *new_elem = methods->at(new_image->pixels, new_col, new_row);
-    memcpy(new_elem, elem, sizeof(struct Pnm_rgb));
+    memcpy(new_elem, elem, pixel_size);
 }
 
 /********** apply_270 ********
@@ -211,6 +265,7 @@ void apply_180(int col, int row, A2Methods_UArray2 uarray,
  *
  * Notes: 
  *      - new col becomes original row 
+ *      - new row is the current col subtracted from width
  *
  ************************/
 void apply_270(int col, int row, A2Methods_UArray2 uarray, 
@@ -219,23 +274,284 @@ void apply_270(int col, int row, A2Methods_UArray2 uarray,
     Pnm_ppm new_image = (Pnm_ppm)cl;
     const struct A2Methods_T *methods = new_image->methods;
 
-    int new_col = methods->height(uarray) - row - 1;
-    int new_row = col;
+    int new_col = row;
+    int new_row = methods->width(uarray) - col - 1;
+
+    void *new_elem = methods->at(new_image->pixels, new_col, new_row);
+    memcpy(new_elem, elem, pixel_size);
+}
+
+/********** apply_flip_horizontal ********
+ *
+ * Mirrors pixel data left to right
+ *
+ * Parameters and expectations are as for apply_copy
+ *
+ * Notes: 
+ *      - new column is the current column subtracted from width
+ ************************/
+void apply_flip_horizontal(int col, int row, A2Methods_UArray2 uarray,
+                           void *elem, void *cl)
+{
+    (void)uarray;
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+
+    int new_col = new_image->width - col - 1;
+    void *new_elem = methods->at(new_image->pixels, new_col, row);
+    memcpy(new_elem, elem, pixel_size);
+}
+
+/********** apply_flip_vertical ********
+ *
+ * Mirrors pixel data top to bottom
+ *
+ * Parameters and expectations are as for apply_copy
+ *
+ * Notes: 
+ *      - new row is the current row subtracted from height
+ ************************/
+void apply_flip_vertical(int col, int row, A2Methods_UArray2 uarray,
+                         void *elem, void *cl)
+{
+    (void)uarray;
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+
+    int new_row = new_image->height - row - 1;
+    void *new_elem = methods->at(new_image->pixels, col, new_row);
+    memcpy(new_elem, elem, pixel_size);
+}
+
+/********** apply_transpose ********
+ *
+ * Reflects pixel data across the top-left to bottom-right diagonal
+ *
+ * Parameters and expectations are as for apply_copy
+ *
+ * Notes: 
+ *      - column and row are swapped
+ ************************/
+void apply_transpose(int col, int row, A2Methods_UArray2 uarray,
+                     void *elem, void *cl)
+{
+    (void)uarray;
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+
+    void *new_elem = methods->at(new_image->pixels, row, col);
+    memcpy(new_elem, elem, pixel_size);
+}
+
+/********** apply_transverse ********
+ *
+ * Reflects pixel data across the top-right to bottom-left diagonal;
+ * only reached by composing a chain such as -rotate 90 -flip vertical
+ *
+ * Parameters and expectations are as for apply_copy
+ *
+ * Notes: 
+ *      - column and row are swapped, then both inverted
+ ************************/
+void apply_transverse(int col, int row, A2Methods_UArray2 uarray,
+                      void *elem, void *cl)
+{
+    (void)uarray;
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+
+    int new_col = new_image->width - row - 1;
+    int new_row = new_image->height - col - 1;
+    void *new_elem = methods->at(new_image->pixels, new_col, new_row);
+    memcpy(new_elem, elem, pixel_size);
+}
+
+/********** span_copy ********
+ *
+ * Copies a horizontal run of pixels to the same positions in the new image
+ *
+ * Parameters:
+ *      int col:     column of the first pixel of the run in original image
+ *      int row:     row of the run in original image
+ *      int length:  number of pixels in the run
+ *      void *first: pointer to the first pixel of the run
+ *      int stride:  bytes from one pixel of the run to the next
+ *      void *cl:    closure that points to Pnm_ppm image struct
+ *
+ * Return:
+ *      none
+ *
+ * Expects:
+ *      - the run lies inside the original image
+ *      - `cl` points to a valid Pnm_ppm struct representing the new image
+ *
+ * Notes: 
+ *      - one call per run instead of per pixel; the destination is still
+ *        reached through methods->at
+ ************************/
+void span_copy(int col, int row, int length, void *first, int stride,
+               void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    char *src = first;
+
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, col + k, row), src,
+               pixel_size);
+    }
+}
+
+/********** span_90 ********
+ *
+ * Rotates a horizontal run of pixels 90 degrees clockwise into the new
+ * image; the run becomes part of a column
+ *
+ * Parameters and expectations are as for span_copy
+ ************************/
+void span_90(int col, int row, int length, void *first, int stride,
+             void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    int new_col = new_image->width - row - 1;  /* new width = old height */
+    char *src = first;
+
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, new_col, col + k), src,
+               pixel_size);
+    }
+}
+
+/********** span_180 ********
+ *
+ * Rotates a horizontal run of pixels 180 degrees into the new image
+ *
+ * Parameters and expectations are as for span_copy
+ ************************/
+void span_180(int col, int row, int length, void *first, int stride,
+              void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    int new_row = new_image->height - row - 1;
+    int new_col = new_image->width - col - 1;
+    char *src = first;
+
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, new_col - k, new_row), src,
+               pixel_size);
+    }
+}
+
+/********** span_270 ********
+ *
+ * Rotates a horizontal run of pixels 270 degrees clockwise into the new
+ * image; the run becomes part of a column, read bottom to top
+ *
+ * Parameters and expectations are as for span_copy
+ ************************/
+void span_270(int col, int row, int length, void *first, int stride,
+              void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    int new_row = new_image->height - col - 1;  /* new height = old width */
+    char *src = first;
+
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, row, new_row - k), src,
+               pixel_size);
+    }
+}
+
+/********** span_flip_horizontal ********
+ *
+ * Mirrors a horizontal run of pixels left to right into the new image
+ *
+ * Parameters and expectations are as for span_copy
+ ************************/
+void span_flip_horizontal(int col, int row, int length, void *first,
+                          int stride, void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    int new_col = new_image->width - col - 1;
+    char *src = first;
+
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, new_col - k, row), src,
+               pixel_size);
+    }
+}
+
+/********** span_flip_vertical ********
+ *
+ * Mirrors a horizontal run of pixels top to bottom into the new image
+ *
+ * Parameters and expectations are as for span_copy
+ ************************/
+void span_flip_vertical(int col, int row, int length, void *first,
+                        int stride, void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    int new_row = new_image->height - row - 1;
+    char *src = first;
 
-    struct Pnm_rgb *new_elem = methods->at(new_image->pixels, new_col, new_row);
-    struct Pnm_rgb *old_elem = elem;
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, col + k, new_row), src,
+               pixel_size);
+    }
+}
 
-    /* explicit copy pixel data from old to new element */
-    new_elem->red = old_elem->red;
-    new_elem->green = old_elem->green;
-    new_elem->blue = old_elem->blue;
+/********** span_transpose ********
+ *
+ * Transposes a horizontal run of pixels into the new image; the run
+ * becomes part of a column
+ *
+ * Parameters and expectations are as for span_copy
+ ************************/
+void span_transpose(int col, int row, int length, void *first, int stride,
+                    void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    char *src = first;
+
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, row, col + k), src,
+               pixel_size);
+    }
 }
 
+/********** span_transverse ********
+ *
+ * Transverses a horizontal run of pixels into the new image; the run
+ * becomes part of a column, read bottom to top
+ *
+ * Parameters and expectations are as for span_copy
+ ************************/
+void span_transverse(int col, int row, int length, void *first, int stride,
+                     void *cl)
+{
+    Pnm_ppm new_image = (Pnm_ppm)cl;
+    const struct A2Methods_T *methods = new_image->methods;
+    int new_col = new_image->width - row - 1;
+    int new_row = new_image->height - col - 1;
+    char *src = first;
+
+    for (int k = 0; k < length; k++, src += stride) {
+        memcpy(methods->at(new_image->pixels, new_col, new_row - k), src,
+               pixel_size);
+    }
+}
 
 /********** main ********
  *
  * Executes the ppm image transformation based on user-specified options,
- * rotation (0, 90, 180, 270 degrees), mapping methods, and timing.
+ * rotation (0, 90, 180, 270 degrees), flip or transpose, mapping
+ * methods, and timing.
  *
  * Parameters:
  *      int argc:              number of command-line arguments
@@ -246,17 +562,30 @@ void apply_270(int col, int row, A2Methods_UArray2 uarray,
  *
  * Expects:
  *      - command-line arguments follow appropriate format
- *      - acceptable rotation degree (0, 90, 180, 270) and mapping options 
- *        are stated
+ *      - acceptable rotation degree (0, 90, 180, 270), flip direction
+ *        and mapping options are stated
  * 
  * Notes:
- *      - writes the rotated image to standard output in binary PPM format
+ *      - -rotate, -flip and -transpose may be repeated; the chain is
+ *        composed into one transformation, applied in a single pass
+ *        (or none, when the chain comes out to the identity)
+ *      - writes the rotated image to standard output in binary PPM format,
+ *        or with -output to a file through a shared mapping
  *
  ************************/
 int main(int argc, char *argv[])
 {
         char *time_file_name = NULL;
+        char *output         = NULL;       /* stdout if NULL */
         int   rotation       = 0;
+        Rotate_op op         = ROTATE_0;   /* composed in order given */
+        bool  hilbert        = false;
+        bool  spans          = false;
+        bool  inlined        = false;
+        bool  direct         = false;
+        bool  oblivious      = false;
+        bool  inplace        = false;
+        const char *format   = "wide";
         int   i;
 
         /* default to UArray2 methods */
@@ -280,6 +609,60 @@ int main(int argc, char *argv[])
                 } else if (strcmp(argv[i], "-block-major") == 0) {
                         SET_METHODS(uarray2_methods_blocked, map_block_major,
                                     "block-major");
+                } else if (strcmp(argv[i], "-block-pow2-major") == 0) {
+                        SET_METHODS(uarray2_methods_blocked_pow2,
+                                    map_block_major, "block-major");
+                } else if (strcmp(argv[i], "-block-cache-major") == 0) {
+                        SET_METHODS(uarray2_methods_blocked_cache,
+                                    map_block_major, "block-major");
+                } else if (strcmp(argv[i], "-block-line-major") == 0) {
+                        SET_METHODS(uarray2_methods_blocked_line,
+                                    map_block_major, "block-major");
+                } else if (strcmp(argv[i], "-hier-block-major") == 0) {
+                        SET_METHODS(uarray2_methods_hierarchical,
+                                    map_block_major, "block-major");
+                } else if (strcmp(argv[i], "-morton-major") == 0) {
+                        SET_METHODS(uarray2_methods_morton, map_default,
+                                    "morton-order");
+                } else if (strcmp(argv[i], "-hilbert-major") == 0) {
+                        /* traverses whichever storage is selected */
+                        hilbert = true;
+                } else if (strcmp(argv[i], "-spans") == 0) {
+                        /* one call per contiguous run, in storage order */
+                        spans = true;
+                } else if (strcmp(argv[i], "-inline") == 0) {
+                        /* traversal and kernel specialized per layout */
+                        inlined = true;
+                } else if (strcmp(argv[i], "-direct") == 0) {
+                        /* destination reached by pointer stepping */
+                        direct = true;
+                } else if (strcmp(argv[i], "-cache-oblivious") == 0) {
+                        /* recursive tiling of plain arrays */
+                        oblivious = true;
+                } else if (strcmp(argv[i], "-inplace") == 0) {
+                        /* overwrite the image; no second array */
+                        inplace = true;
+                } else if (strcmp(argv[i], "-output") == 0) {
+                        /* write a file through a mapping */
+                        if (!(i + 1 < argc)) {
+                                usage(argv[0]);
+                        }
+                        output = argv[++i];
+                } else if (strcmp(argv[i], "-format") == 0) {
+                        /* pixel storage between read and write */
+                        if (!(i + 1 < argc)) {
+                                usage(argv[0]);
+                        }
+                        format = argv[++i];
+                        if (strcmp(format, "wide") != 0
+                            && strcmp(format, "packed") != 0
+                            && strcmp(format, "aligned") != 0
+                            && strcmp(format, "planar") != 0) {
+                                fprintf(stderr, "Format must be wide, "
+                                                "packed, aligned or "
+                                                "planar\n");
+                                usage(argv[0]);
+                        }
                 } else if (strcmp(argv[i], "-rotate") == 0) {
                         if (!(i + 1 < argc)) {      /* no rotate value */
                                 usage(argv[0]);
@@ -295,6 +678,25 @@ int main(int argc, char *argv[])
                         if (!(*endptr == '\0')) {    /* Not a number */
                                 usage(argv[0]);
                         }
+                        op = Rotate_compose(op, Rotate_degrees(rotation));
+                } else if (strcmp(argv[i], "-flip") == 0) {
+                        if (!(i + 1 < argc)) {      /* no direction */
+                                usage(argv[0]);
+                        }
+                        i++;
+                        if (strcmp(argv[i], "horizontal") == 0) {
+                                op = Rotate_compose(op,
+                                                ROTATE_FLIP_HORIZONTAL);
+                        } else if (strcmp(argv[i], "vertical") == 0) {
+                                op = Rotate_compose(op,
+                                                ROTATE_FLIP_VERTICAL);
+                        } else {
+                                fprintf(stderr, "Flip must be horizontal "
+                                                "or vertical\n");
+                                usage(argv[0]);
+                        }
+                } else if (strcmp(argv[i], "-transpose") == 0) {
+                        op = Rotate_compose(op, ROTATE_TRANSPOSE);
                 } else if (strcmp(argv[i], "-time") == 0) {
                         if (!(i + 1 < argc)) {      /* no time file */
                                 usage(argv[0]);
@@ -312,63 +714,199 @@ int main(int argc, char *argv[])
                 }
         }
 
-        /* open file */
-        FILE *file = (i < argc) ? fopen(argv[i], "r") : stdin;
-        if (file == NULL) {
-                fprintf(stderr, "Error: cannot open file %s\n", argv[i]);
-                free_memory(&image, &trans_image);
-                exit(EXIT_FAILURE);
+        if (hilbert) {
+                map = methods->map_hilbert;
+                if (map == NULL) {
+                        fprintf(stderr, "%s does not support "
+                                        "hilbert-order mapping\n", argv[0]);
+                        exit(1);
+                }
         }
 
-        /* Read the PPM image */
-        image = Pnm_ppmread(file, methods);
-        if (file != stdin) {
-                fclose(file);
+        if (spans && methods->map_spans == NULL) {
+                fprintf(stderr, "%s does not support span mapping\n",
+                        argv[0]);
+                exit(1);
         }
 
-        /* Array to hold rotated image */
-        A2Methods_UArray2 rotated;
-        if (rotation == 90 || rotation == 270) {
-                rotated = methods->new(image->height, image->width, 
-                        sizeof(struct Pnm_rgb));
-        } else {
-                rotated = methods->new(image->width, image->height, 
-                        sizeof(struct Pnm_rgb));
+        if ((inlined || direct) && !Rotate_has_layout(methods)) {
+                fprintf(stderr, "%s does not support %s rotation\n",
+                        argv[0], inlined ? "inline" : "direct");
+                exit(1);
         }
 
-        /* transformed image struct */
-        trans_image = malloc(sizeof(*trans_image));
-        if (trans_image == NULL) {
-                free_memory(&image, &trans_image);
-                exit(EXIT_FAILURE);
+        if (oblivious && methods != uarray2_methods_plain) {
+                fprintf(stderr, "%s: -cache-oblivious needs plain "
+                                "(row-major) storage\n", argv[0]);
+                exit(1);
         }
 
-        /* initialize fields */
-        trans_image->width = methods->width(rotated);
-        trans_image->height = methods->height(rotated);
-        trans_image->denominator = image->denominator;
-        trans_image->pixels = rotated;
-        trans_image->methods = methods;
+        if (inplace && (inlined || direct || oblivious || spans)) {
+                fprintf(stderr, "%s: -inplace cannot be combined with "
+                                "-inline, -direct, -cache-oblivious or "
+                                "-spans\n", argv[0]);
+                exit(1);
+        }
+
+        /* Read the PPM image through ppmio, into the compact formats
+         * (8- or 16-bit), struct Pnm_rgb or three planes, in any
+         * storage.  A raw file going to packed, plain, read-only
+         * storage is mapped instead, and transformed out of the page
+         * cache */
+        Pixfmt fmt = PIXFMT_WIDE;
+        bool planar  = strcmp(format, "planar") == 0;
+        bool packed  = !planar && strcmp(format, "wide") != 0;
+        bool aligned = strcmp(format, "aligned") == 0;
+        bool mapped  = false;
+        A2Methods_UArray2 planes[3], trans_planes[3];
+        if (packed && !aligned && !inplace && i < argc
+            && methods == uarray2_methods_plain
+            && !same_file(argv[i], output)) {
+                image = Ppmio_map(argv[i], &fmt);
+                mapped = image != NULL;
+        }
+        if (!mapped) {
+                /* open file */
+                FILE *file = (i < argc) ? fopen(argv[i], "r") : stdin;
+                if (file == NULL) {
+                        fprintf(stderr, "Error: cannot open file %s\n",
+                                argv[i]);
+                        free_memory(&image, &trans_image);
+                        exit(EXIT_FAILURE);
+                }
+                image = planar ? Ppmio_read_planes(file, methods, planes)
+                      : packed ? Ppmio_read(file, methods, aligned, &fmt)
+                               : Ppmio_read_wide(file, methods);
+                if (file != stdin) {
+                        fclose(file);
+                }
+                if (image == NULL) {
+                        fprintf(stderr, "%s: input is not a PPM\n",
+                                argv[0]);
+                        exit(1);
+                }
+        }
+        if (packed) {
+                pixel_size = Pixfmt_size(fmt);
+        }
+
+        /* a planar image is transformed one plane at a time */
+        int nplanes = planar ? 3 : 1;
+        if (planar) {
+                pixel_size = Pixfmt_plane_size(image->denominator);
+        }
+
+        /* the identity (-rotate 0, or a chain that cancels out) needs
+         * no traversal: the image is written back as read */
+        bool identity = (op == ROTATE_0);
+
+        if (!identity && !inplace) {
+                /* Array (one per plane) to hold rotated image */
+                A2Methods_UArray2 rotated = NULL;
+                for (int p = 0; p < nplanes; p++) {
+                        if (op & ROTATE_TRANSPOSE) {
+                                rotated = methods->new(image->height,
+                                        image->width, pixel_size);
+                        } else {
+                                rotated = methods->new(image->width,
+                                        image->height, pixel_size);
+                        }
+                        trans_planes[p] = rotated;
+                }
+
+                /* transformed image struct */
+                trans_image = malloc(sizeof(*trans_image));
+                if (trans_image == NULL) {
+                        for (int p = 0; p < nplanes; p++) {
+                                methods->free(&trans_planes[p]);
+                        }
+                        free_memory(&image, &trans_image);
+                        exit(EXIT_FAILURE);
+                }
+
+                /* initialize fields */
+                trans_image->width = methods->width(rotated);
+                trans_image->height = methods->height(rotated);
+                trans_image->denominator = image->denominator;
+                trans_image->pixels = rotated;
+                trans_image->methods = methods;
+        }
+
+        /* reference kernels for op */
+        A2Methods_spanfun *span_fn =
+                  op == ROTATE_90              ? span_90
+                : op == ROTATE_180             ? span_180
+                : op == ROTATE_270             ? span_270
+                : op == ROTATE_FLIP_HORIZONTAL ? span_flip_horizontal
+                : op == ROTATE_FLIP_VERTICAL   ? span_flip_vertical
+                : op == ROTATE_TRANSPOSE       ? span_transpose
+                : op == ROTATE_TRANSVERSE      ? span_transverse
+                : span_copy;
+        A2Methods_applyfun *apply_fn =
+                  op == ROTATE_90              ? apply_90
+                : op == ROTATE_180             ? apply_180
+                : op == ROTATE_270             ? apply_270
+                : op == ROTATE_FLIP_HORIZONTAL ? apply_flip_horizontal
+                : op == ROTATE_FLIP_VERTICAL   ? apply_flip_vertical
+                : op == ROTATE_TRANSPOSE       ? apply_transpose
+                : op == ROTATE_TRANSVERSE      ? apply_transverse
+                : apply_copy;
 
         /* Create timer */
         CPUTime_T timer = CPUTime_New();
         CPUTime_Start(timer);
 
-        /* Complete the rotation */
-        if (rotation == 0) {
-                map(image->pixels, apply_copy, trans_image);
-        } else if (rotation == 90) {
-                map(image->pixels, apply_90, trans_image);
-        } else if (rotation == 180) {
-                map(image->pixels, apply_180, trans_image);
-        } else if (rotation == 270) {
-                map(image->pixels, apply_270, trans_image);
+        /* Complete the rotation, plane by plane if planar */
+        for (int p = 0; p < nplanes; p++) {
+                A2Methods_UArray2 src = planar ? planes[p] : image->pixels;
+                A2Methods_UArray2 dst = NULL;
+                if (trans_image != NULL) {
+                        dst = planar ? trans_planes[p] : trans_image->pixels;
+                        trans_image->pixels = dst;   /* for apply_fn */
+                }
+
+                if (identity) {
+                        /* nothing to move */
+                } else if (inplace) {
+                        if (!Rotate_inplace(methods, src, op)) {
+                                fprintf(stderr, "%s: -inplace needs plain "
+                                                "(row-major) storage to "
+                                                "transpose a non-square "
+                                                "image\n", argv[0]);
+                                free_memory(&image, &trans_image);
+                                exit(1);
+                        }
+                } else if (oblivious) {
+                        Rotate_oblivious(methods, src, dst, op);
+                } else if (direct) {
+                        Rotate_direct(methods, src, dst, op);
+                } else if (inlined) {
+                        if (!Rotate_inline(methods, src, dst, op)) {
+                                fprintf(stderr, "%s: no inline kernel for "
+                                                "%s pixels\n", argv[0],
+                                                Pixfmt_name(fmt));
+                                free_memory(&image, &trans_image);
+                                exit(1);
+                        }
+                } else if (spans) {
+                        methods->map_spans(src, span_fn, trans_image);
+                } else {
+                        map(src, apply_fn, trans_image);
+                }
         }
 
         /* Stop timer */ 
         double total_time = CPUTime_Stop(timer);
         CPUTime_Free(&timer);
 
+        /* an in-place transform may have swapped the dimensions */
+        int width  = image->width;
+        int height = image->height;
+        if (inplace) {
+                image->width  = methods->width(image->pixels);
+                image->height = methods->height(image->pixels);
+        }
+
         /* Calculate total number of pixels */
         int total_pixels = image->width * image->height;
         double time_per_pixel = total_time / total_pixels;
@@ -383,21 +921,81 @@ int main(int argc, char *argv[])
                 }
 
                 /* Append rotation and timing information */
-                fprintf(file_time, "Rotation: %d degrees\n", rotation);
-                fprintf(file_time, "Width: %d, Height: %d\n", image->width, 
-                        image->height);
+                if (op == ROTATE_0 || op == ROTATE_90 || op == ROTATE_180
+                    || op == ROTATE_270) {
+                        fprintf(file_time, "Rotation: %d degrees\n",
+                                op == ROTATE_90  ? 90
+                              : op == ROTATE_180 ? 180
+                              : op == ROTATE_270 ? 270 : 0);
+                } else {
+                        fprintf(file_time, "Transformation: %s\n",
+                                Rotate_name(op));
+                }
+                fprintf(file_time, "Width: %d, Height: %d\n", width,
+                        height);
                 fprintf(file_time, "Total time: %.0f nanoseconds\n", 
                         total_time);
                 fprintf(file_time, "Total pixels: %d\n", total_pixels);
-                fprintf(file_time, "Time per pixel: %.3f nanoseconds\n\n", 
+                fprintf(file_time, "Time per pixel: %.3f nanoseconds\n", 
                         time_per_pixel);
+                if (planar) {
+                        fprintf(file_time, "Pixel format: planar (3 planes "
+                                "of %d-byte samples)\n", pixel_size);
+                } else if (fmt != PIXFMT_WIDE) {
+                        fprintf(file_time, "Pixel format: %s (%d bytes)\n",
+                                Pixfmt_name(fmt), pixel_size);
+                }
+                if (methods == uarray2_methods_blocked_cache) {
+                        int level = Cache_target_level();
+                        if (level > 0) {
+                                fprintf(file_time, "Cache target: L%d "
+                                        "(%ld bytes), ", level,
+                                        Cache_size(level));
+                        } else {
+                                fprintf(file_time, "Cache target: unknown "
+                                        "(64KB blocks), ");
+                        }
+                        fprintf(file_time, "blocksize %d\n",
+                                methods->blocksize(image->pixels));
+                }
+                fprintf(file_time, "\n");
                 fclose(file_time);
         } 
 
-        /* write transformed image */
-        Pnm_ppmwrite(stdout, trans_image);
+        /* write transformed image, straight from the planes if planar;
+         * then only the planes the images do not hold are left */
+        Pnm_ppm result = identity || inplace ? image : trans_image;
+        A2Methods_UArray2 *out = result == image ? planes : trans_planes;
+        bool written;
+        if (planar) {
+                written = output != NULL
+                          ? Ppmio_write_planes_map(output, result, out)
+                          : Ppmio_write_planes(stdout, result, out);
+        } else {
+                written = output != NULL
+                          ? Ppmio_write_map(output, result, fmt)
+                          : Ppmio_write(stdout, result, fmt);
+        }
+        if (planar) {
+                image->pixels = planes[0];
+                methods->free(&planes[1]);
+                methods->free(&planes[2]);
+                if (trans_image != NULL) {
+                        trans_image->pixels = trans_planes[0];
+                        methods->free(&trans_planes[1]);
+                        methods->free(&trans_planes[2]);
+                }
+        }
+        if (!written) {
+                fprintf(stderr, "%s: cannot write %s\n", argv[0],
+                        output != NULL ? output : "standard output");
+                exit(1);
+        }
 
         /* Free memory */
+        if (mapped) {
+                Ppmio_unmap(&image);
+        }
         free_memory(&image, &trans_image);
 
         return 0; 
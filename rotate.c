@@ -0,0 +1,876 @@
+/**************************************************************
+ *
+ *                     rotate.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall
+ *     Date:       October 7, 2024
+ *
+ *     Rotations, flips and transposes of plain and blocked arrays,
+ *     three ways: with the traversal and the per-pixel kernel
+ *     specialized at compile time (see a2inline.h) for -inline, by
+ *     destination-pointer stepping for -direct, and by recursive
+ *     tiling for -cache-oblivious; plus in-place versions for
+ *     -inplace.  ppmtrans's apply_* functions
+ *     remain the reference implementation through A2Methods_T.
+ *
+ **************************************************************/
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "assert.h"
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "a2inline.h"
+#include "pnm.h"
+#include "rotate.h"
+#include "tile.h"
+#include "uarray2.h"
+#include "uarray2b.h"
+
+typedef struct Pnm_rgb Pixel;
+
+/********** Rotate_degrees ********
+ *
+ * Returns the op for a clockwise rotation by 'degrees'
+ ************************/
+Rotate_op Rotate_degrees(int degrees)
+{
+        switch (degrees) {
+        case 0:   return ROTATE_0;
+        case 90:  return ROTATE_90;
+        case 180: return ROTATE_180;
+        case 270: return ROTATE_270;
+        }
+        assert(0);
+        return ROTATE_0;
+}
+
+/*
+ * Composition works on 2x2 signed permutation matrices acting on
+ * coordinates measured from the center of the array, where a flip is
+ * a negation and a transpose a swap.  m[0..3] is row-major.
+ */
+static void op_matrix(Rotate_op op, int m[4])
+{
+        int sx = (op & ROTATE_FLIP_X) ? -1 : 1;
+        int sy = (op & ROTATE_FLIP_Y) ? -1 : 1;
+
+        if (op & ROTATE_TRANSPOSE) {
+                m[0] = 0;  m[1] = sx;
+                m[2] = sy; m[3] = 0;
+        } else {
+                m[0] = sx; m[1] = 0;
+                m[2] = 0;  m[3] = sy;
+        }
+}
+
+/********** Rotate_compose ********
+ *
+ * Returns the op that does 'first' followed by 'then', so that a
+ * chain of any length costs one traversal
+ ************************/
+Rotate_op Rotate_compose(Rotate_op first, Rotate_op then)
+{
+        int a[4], b[4], m[4];
+        op_matrix(first, a);
+        op_matrix(then, b);
+
+        m[0] = b[0] * a[0] + b[1] * a[2];
+        m[1] = b[0] * a[1] + b[1] * a[3];
+        m[2] = b[2] * a[0] + b[3] * a[2];
+        m[3] = b[2] * a[1] + b[3] * a[3];
+
+        int op = 0;
+        if (m[0] == 0)
+                op |= ROTATE_TRANSPOSE;
+        if (m[0] + m[1] < 0)
+                op |= ROTATE_FLIP_X;
+        if (m[2] + m[3] < 0)
+                op |= ROTATE_FLIP_Y;
+        return (Rotate_op)op;
+}
+
+/********** Rotate_name ********
+ *
+ * Returns a printable name for 'op'
+ ************************/
+const char *Rotate_name(Rotate_op op)
+{
+        static const char *names[8] = {
+                "rotate 0",   "flip horizontal", "flip vertical",
+                "rotate 180", "transpose",       "rotate 90",
+                "rotate 270", "transverse"
+        };
+        assert((unsigned)op < 8);
+        return names[op];
+}
+
+/********** dest_cell ********
+ *
+ * Stores in *col and *row where source cell (i, j) of a 'width' by
+ * 'height' array goes under 'op'; with 'op' a constant this folds to
+ * the index arithmetic for that op
+ ************************/
+static inline void dest_cell(Rotate_op op, int i, int j, int width,
+                             int height, int *col, int *row)
+{
+        int x = i, y = j, dw = width, dh = height;
+
+        if (op & ROTATE_TRANSPOSE) {
+                x  = j;      y  = i;
+                dw = height; dh = width;
+        }
+        *col = (op & ROTATE_FLIP_X) ? dw - x - 1 : x;
+        *row = (op & ROTATE_FLIP_Y) ? dh - y - 1 : y;
+}
+
+/* closure for the kernels: destination view and source dimensions */
+struct plain_rotation {
+        A2Inline_plain dst;
+        int width, height;
+};
+
+struct blocked_rotation {
+        A2Inline_blocked dst;
+        int width, height;
+};
+
+/* cell types of each size in pixfmt.h, and of the samples of a planar
+ * image, so that kernels move whole cells with fixed-size copies
+ */
+typedef uint8_t                   Cell1;
+typedef uint16_t                  Cell2;
+typedef struct { uint8_t  b[3]; } Cell3;
+typedef uint32_t                  Cell4;
+typedef struct { uint8_t  b[6]; } Cell6;   /* any alignment: a mapped
+                                               raster may be odd */
+typedef uint64_t                  Cell8;
+
+/* copies 'n' contiguous 'TYPE' cells from 'src' to 'dst', stepping
+ * 'step' bytes between destination cells */
+#define STEP_CELLS(TYPE, dst, step, src, n)                             \
+        for (int k_ = 0; k_ < (n); k_++, (dst) += (step))               \
+                *(TYPE *)(dst) = ((const TYPE *)(src))[k_]
+
+/********** step_cells ********
+ *
+ * STEP_CELLS for cells of 'size' bytes, with a fixed-size copy for
+ * every size above
+ ************************/
+static inline void step_cells(char *dst, ptrdiff_t step, const char *src,
+                              int n, int size)
+{
+        switch (size) {
+        case sizeof(Cell1): STEP_CELLS(Cell1, dst, step, src, n); break;
+        case sizeof(Cell2): STEP_CELLS(Cell2, dst, step, src, n); break;
+        case sizeof(Cell3): STEP_CELLS(Cell3, dst, step, src, n); break;
+        case sizeof(Cell4): STEP_CELLS(Cell4, dst, step, src, n); break;
+        case sizeof(Cell6): STEP_CELLS(Cell6, dst, step, src, n); break;
+        case sizeof(Cell8): STEP_CELLS(Cell8, dst, step, src, n); break;
+        case sizeof(Pixel): STEP_CELLS(Pixel, dst, step, src, n); break;
+        default:
+                for (int k = 0; k < n; k++, dst += step, src += size)
+                        memcpy(dst, src, size);
+        }
+}
+
+typedef void Plain_map(const A2Inline_plain *, void *);
+typedef void Blocked_map(const A2Inline_blocked *, void *);
+
+/*
+ * defines a kernel that copies the source cell at (i, j) to where
+ * 'OP' sends it in the destination
+ */
+#define ROTATE_KERNEL(NAME, CLOSURE, AT, OP, TYPE)                      \
+static inline void NAME(int i, int j, TYPE *elem, void *cl)             \
+{                                                                       \
+        struct CLOSURE *r = cl;                                         \
+        int col, row;                                                   \
+        dest_cell((OP), i, j, r->width, r->height, &col, &row);         \
+        *(TYPE *)AT(&r->dst, col, row) = *elem;                         \
+}
+
+/* defines the kernels and traversals of 'OP' for both layouts */
+#define ROTATE_INLINE(SUFFIX, OP, TYPE)                                 \
+ROTATE_KERNEL(plain_##SUFFIX, plain_rotation, A2Inline_plain_at, OP,    \
+              TYPE)                                                     \
+ROTATE_KERNEL(blocked_##SUFFIX, blocked_rotation, A2Inline_blocked_at,  \
+              OP, TYPE)                                                 \
+A2INLINE_PLAIN_ROW_MAJOR(plain_map_##SUFFIX, TYPE, plain_##SUFFIX)      \
+A2INLINE_BLOCKED_BLOCK_MAJOR(blocked_map_##SUFFIX, TYPE,                \
+                             blocked_##SUFFIX)
+
+/* defines all eight ops for cells of 'TYPE', and tables of them
+ * indexed by Rotate_op
+ */
+#define ROTATE_INLINE_TYPE(T, TYPE)                                     \
+ROTATE_INLINE(T##_0,   ROTATE_0,               TYPE)                    \
+ROTATE_INLINE(T##_fh,  ROTATE_FLIP_HORIZONTAL, TYPE)                    \
+ROTATE_INLINE(T##_fv,  ROTATE_FLIP_VERTICAL,   TYPE)                    \
+ROTATE_INLINE(T##_180, ROTATE_180,             TYPE)                    \
+ROTATE_INLINE(T##_tr,  ROTATE_TRANSPOSE,       TYPE)                    \
+ROTATE_INLINE(T##_90,  ROTATE_90,              TYPE)                    \
+ROTATE_INLINE(T##_270, ROTATE_270,             TYPE)                    \
+ROTATE_INLINE(T##_tv,  ROTATE_TRANSVERSE,      TYPE)                    \
+static Plain_map *const plain_maps_##T[8] = {                           \
+        plain_map_##T##_0,  plain_map_##T##_fh,                         \
+        plain_map_##T##_fv, plain_map_##T##_180,                        \
+        plain_map_##T##_tr, plain_map_##T##_90,                         \
+        plain_map_##T##_270, plain_map_##T##_tv                         \
+};                                                                      \
+static Blocked_map *const blocked_maps_##T[8] = {                       \
+        blocked_map_##T##_0,  blocked_map_##T##_fh,                     \
+        blocked_map_##T##_fv, blocked_map_##T##_180,                    \
+        blocked_map_##T##_tr, blocked_map_##T##_90,                     \
+        blocked_map_##T##_270, blocked_map_##T##_tv                     \
+};
+
+ROTATE_INLINE_TYPE(c1,  Cell1)
+ROTATE_INLINE_TYPE(c2,  Cell2)
+ROTATE_INLINE_TYPE(c3,  Cell3)
+ROTATE_INLINE_TYPE(c4,  Cell4)
+ROTATE_INLINE_TYPE(c6,  Cell6)
+ROTATE_INLINE_TYPE(c8,  Cell8)
+ROTATE_INLINE_TYPE(c12, Pixel)
+
+/********** inline_maps ********
+ *
+ * Stores in *plain and *blocked the traversal tables for cells of
+ * 'size' bytes; false if there are none
+ ************************/
+static bool inline_maps(int size, Plain_map *const **plain,
+                        Blocked_map *const **blocked)
+{
+        switch (size) {
+        case sizeof(Cell1):
+                *plain = plain_maps_c1;  *blocked = blocked_maps_c1;
+                return true;
+        case sizeof(Cell2):
+                *plain = plain_maps_c2;  *blocked = blocked_maps_c2;
+                return true;
+        case sizeof(Cell3):
+                *plain = plain_maps_c3;  *blocked = blocked_maps_c3;
+                return true;
+        case sizeof(Cell4):
+                *plain = plain_maps_c4;  *blocked = blocked_maps_c4;
+                return true;
+        case sizeof(Cell6):
+                *plain = plain_maps_c6;  *blocked = blocked_maps_c6;
+                return true;
+        case sizeof(Cell8):
+                *plain = plain_maps_c8;  *blocked = blocked_maps_c8;
+                return true;
+        case sizeof(Pixel):
+                *plain = plain_maps_c12; *blocked = blocked_maps_c12;
+                return true;
+        }
+        return false;
+}
+
+/*
+ * a destination line: the source run starting at (i, j) lands at
+ * (col, row) and continues one cell in direction (dcol, drow) per cell
+ */
+struct line {
+        int col, row;
+        int dcol, drow;
+};
+
+/********** dest_line ********
+ *
+ * Returns where a horizontal source run starting at (i, j) goes when
+ * a 'width' by 'height' array is transformed by 'op'
+ ************************/
+static inline struct line dest_line(Rotate_op op, int i, int j,
+                                    int width, int height)
+{
+        struct line l;
+        dest_cell(op, i, j, width, height, &l.col, &l.row);
+        if (op & ROTATE_TRANSPOSE) {
+                l.dcol = 0;
+                l.drow = (op & ROTATE_FLIP_Y) ? -1 : 1;
+        } else {
+                l.dcol = (op & ROTATE_FLIP_X) ? -1 : 1;
+                l.drow = 0;
+        }
+        return l;
+}
+
+/********** move_cells ********
+ *
+ * Copies 'n' contiguous source cells of 'size' bytes to 'dst',
+ * stepping 'step' bytes between destination cells
+ *
+ * Notes:
+ *      - forward runs (whole rows of a vertical flip, say) are one
+ *        memcpy; backward runs of 1-, 2-, 3-, 4- and 8-byte cells use
+ *        the SIMD reversals of tile.h
+ ************************/
+static inline void move_cells(char *dst, ptrdiff_t step, const char *src,
+                              int n, int size)
+{
+        const Tile_kernel *tile = step == -size ? Tile_kernel_for(size)
+                                                : NULL;
+
+        if (step == size) {
+                memcpy(dst, src, (size_t)n * size);
+        } else if (tile != NULL) {
+                tile->reverse(src, dst + (n - 1) * step, n);
+        } else {
+                step_cells(dst, step, src, n, size);
+        }
+}
+
+/********** plain_line ********
+ *
+ * Copies 'n' contiguous source cells along line 'l' of the plain
+ * destination 'd'; the destination pointer advances by one cell or
+ * one row stride per step
+ ************************/
+static inline void plain_line(const A2Inline_plain *d, struct line l,
+                              const char *src, int n)
+{
+        ptrdiff_t step = l.dcol * (ptrdiff_t)d->size
+                       + l.drow * (ptrdiff_t)d->stride;
+        move_cells(A2Inline_plain_at(d, l.col, l.row), step, src, n,
+                   d->size);
+}
+
+/********** blocked_line ********
+ *
+ * Copies 'n' contiguous source cells along line 'l' of the blocked
+ * destination 'd'
+ *
+ * Notes:
+ *      - the line is cut where it leaves a destination block; the
+ *        block is located once per piece and the cells inside it are
+ *        reached by pointer stepping
+ ************************/
+static inline void blocked_line(const A2Inline_blocked *d, struct line l,
+                                const char *src, int n)
+{
+        const int bw = d->block_width, bh = d->block_height;
+        const ptrdiff_t step = (l.dcol + (ptrdiff_t)l.drow * bw) * d->size;
+
+        while (n > 0) {
+                int bcol = l.col / bw, brow = l.row / bh;
+                int in_col = l.col - bcol * bw, in_row = l.row - brow * bh;
+                int room = l.dcol > 0 ? bw - in_col
+                         : l.dcol < 0 ? in_col + 1
+                         : l.drow > 0 ? bh - in_row
+                         :              in_row + 1;
+                int k = n < room ? n : room;
+
+                char *p = d->base + d->block_bytes
+                          * ((size_t)brow * d->col_blocks + bcol)
+                          + (size_t)(in_row * bw + in_col) * d->size;
+                move_cells(p, step, src, k, d->size);
+
+                src   += (size_t)k * d->size;
+                n     -= k;
+                l.col += l.dcol * k;
+                l.row += l.drow * k;
+        }
+}
+
+/********** Rotate_has_layout ********
+ *
+ * Returns true if Rotate_inline can handle arrays made by 'methods'
+ ************************/
+bool Rotate_has_layout(A2Methods_T methods)
+{
+        return methods == uarray2_methods_plain
+            || A2Blocked_is_blocked(methods);
+}
+
+/********** Rotate_inline ********
+ *
+ * Transforms 'src' by 'op' into 'dst'
+ *
+ * Parameters:
+ *      A2Methods_T methods:   suite that made both arrays
+ *      A2Methods_UArray2 src: source image, in one of the pixfmt.h
+ *                             formats
+ *      A2Methods_UArray2 dst: destination with the transformed
+ *                             dimensions and the same cell size
+ *      Rotate_op op:          which of the eight symmetries
+ *
+ * Return:
+ *      false if 'methods' is not a plain or blocked suite, or there is
+ *      no kernel for the cell size, else true
+ *
+ * Notes:
+ *      - the source is read in its storage order; the destination is
+ *        written through the inline 'at' of its layout
+ ************************/
+bool Rotate_inline(A2Methods_T methods, A2Methods_UArray2 src,
+                   A2Methods_UArray2 dst, Rotate_op op)
+{
+        Plain_map *const *plain_maps;
+        Blocked_map *const *blocked_maps;
+
+        assert(methods != NULL && src != NULL && dst != NULL);
+        assert((unsigned)op < 8);
+        if (!Rotate_has_layout(methods)
+            || !inline_maps(methods->size(src), &plain_maps, &blocked_maps))
+                return false;
+
+        if (methods == uarray2_methods_plain) {
+                A2Inline_plain v = A2Inline_plain_view(src);
+                struct plain_rotation r;
+                r.dst    = A2Inline_plain_view(dst);
+                r.width  = v.width;
+                r.height = v.height;
+                plain_maps[op](&v, &r);
+                return true;
+        }
+        if (A2Blocked_is_blocked(methods)) {
+                A2Inline_blocked v = A2Inline_blocked_view(src);
+                struct blocked_rotation r;
+                r.dst    = A2Inline_blocked_view(dst);
+                r.width  = v.width;
+                r.height = v.height;
+                blocked_maps[op](&v, &r);
+                return true;
+        }
+        return false;
+}
+
+/********** Rotate_direct ********
+ *
+ * Transforms 'src' by 'op' into 'dst', moving a run of source cells
+ * at a time
+ *
+ * Parameters:
+ *      A2Methods_T methods:   suite that made both arrays
+ *      A2Methods_UArray2 src: source array
+ *      A2Methods_UArray2 dst: destination with the transformed
+ *                             dimensions and the same cell size
+ *      Rotate_op op:          which of the eight symmetries
+ *
+ * Return:
+ *      false if 'methods' is not a plain or blocked suite, else true
+ *
+ * Notes:
+ *      - plain sources are read a row at a time, blocked sources a
+ *        block row at a time, so runs are contiguous in memory
+ *      - destination addresses are computed once per run (and per
+ *        destination block crossed), then stepped
+ ************************/
+bool Rotate_direct(A2Methods_T methods, A2Methods_UArray2 src,
+                   A2Methods_UArray2 dst, Rotate_op op)
+{
+        assert(methods != NULL && src != NULL && dst != NULL);
+        assert((unsigned)op < 8);
+
+        if (methods == uarray2_methods_plain) {
+                A2Inline_plain s = A2Inline_plain_view(src);
+                A2Inline_plain d = A2Inline_plain_view(dst);
+                assert(s.size == d.size);
+
+                for (int j = 0; j < s.height; j++) {
+                        plain_line(&d, dest_line(op, 0, j, s.width,
+                                                 s.height),
+                                   A2Inline_plain_at(&s, 0, j), s.width);
+                }
+                return true;
+        }
+        if (A2Blocked_is_blocked(methods)) {
+                A2Inline_blocked s = A2Inline_blocked_view(src);
+                A2Inline_blocked d = A2Inline_blocked_view(dst);
+                const int bw = s.block_width, bh = s.block_height;
+                const size_t row_bytes = (size_t)bw * s.size;
+                assert(s.size == d.size);
+
+                for (int j0 = 0; j0 < s.height; j0 += bh) {
+                        int h = s.height - j0 < bh ? s.height - j0 : bh;
+                        for (int i0 = 0; i0 < s.width; i0 += bw) {
+                                int w = s.width - i0 < bw ? s.width - i0
+                                                          : bw;
+                                const char *block =
+                                        A2Inline_blocked_at(&s, i0, j0);
+                                for (int j = 0; j < h; j++) {
+                                        struct line l = dest_line(
+                                                op, i0, j0 + j,
+                                                s.width, s.height);
+                                        blocked_line(&d, l,
+                                                     block + j * row_bytes,
+                                                     w);
+                                }
+                        }
+                }
+                return true;
+        }
+        return false;
+}
+
+/*
+ * Cache-oblivious turns.  For ops that transpose, source cell (i, j)
+ * goes to destination column col0 + dcol * j and row row0 + drow * i,
+ * so a tile of source rows becomes a tile of destination columns.
+ * Cells of 1, 2, 4 or 8 bytes (planar samples, packed RGBX and RGBX16)
+ * are moved by the SIMD tile kernels.
+ */
+struct turn {
+        A2Inline_plain src, dst;
+        int col0, dcol;
+        int row0, drow;
+        const Tile_kernel *tile;        /* NULL unless tile.h has one */
+};
+
+/* tiles at most this many cells on a side are rotated directly; 16
+ * rows of 16 pixels from each array fit in any L1, and splits fall on
+ * multiples of 16 so every tile kernel sees whole tiles
+ */
+#define OBLIVIOUS_BASE 16
+
+/********** turn_cells ********
+ *
+ * Scalar case: moves the source rectangle [i0, i1) x [j0, j1) a cell at
+ * a time; the source is read a row at a time and the destination
+ * written down a column
+ ************************/
+static void turn_cells(const struct turn *t, int i0, int i1, int j0, int j1)
+{
+        const ptrdiff_t step = t->drow * (ptrdiff_t)t->dst.stride;
+        const int size = t->src.size;
+
+        for (int j = j0; j < j1; j++) {
+                const char *src = A2Inline_plain_at(&t->src, i0, j);
+                char *dst = A2Inline_plain_at(&t->dst, t->col0 + t->dcol * j,
+                                              t->row0 + t->drow * i0);
+                step_cells(dst, step, src, i1 - i0, size);
+        }
+}
+
+/********** turn_tile ********
+ *
+ * Base case: moves the source rectangle [i0, i1) x [j0, j1), using the
+ * tile kernel for every whole tile and turn_cells for what is left
+ *
+ * Notes:
+ *      - the kernel transposes; 90 degrees reads the source rows bottom
+ *        up and 270 writes the destination rows bottom up, both by
+ *        passing a negative stride
+ ************************/
+static void turn_tile(const struct turn *t, int i0, int i1, int j0, int j1)
+{
+        if (t->tile == NULL) {
+                turn_cells(t, i0, i1, j0, j1);
+                return;
+        }
+
+        const int n = t->tile->side;
+        const int in = i0 + (i1 - i0) / n * n, jn = j0 + (j1 - j0) / n * n;
+        const ptrdiff_t src_stride = t->dcol * (ptrdiff_t)t->src.stride;
+        const ptrdiff_t dst_stride = t->drow * (ptrdiff_t)t->dst.stride;
+
+        for (int j = j0; j < jn; j += n) {
+                int first = t->dcol > 0 ? j : j + n - 1;   /* source row */
+                for (int i = i0; i < in; i += n) {
+                        t->tile->transpose(
+                                A2Inline_plain_at(&t->src, i, first),
+                                src_stride,
+                                A2Inline_plain_at(&t->dst,
+                                                  t->col0 + t->dcol * first,
+                                                  t->row0 + t->drow * i),
+                                dst_stride);
+                }
+        }
+        turn_cells(t, in, i1, j0, j1);
+        turn_cells(t, i0, in, jn, j1);
+}
+
+/********** split ********
+ *
+ * Returns where to cut a side of 'length' cells starting at 'lo':
+ * about halfway, on a multiple of OBLIVIOUS_BASE
+ ************************/
+static inline int split(int lo, int length)
+{
+        int half = length / 2 / OBLIVIOUS_BASE * OBLIVIOUS_BASE;
+        return lo + (half > 0 ? half : OBLIVIOUS_BASE);
+}
+
+/********** turn_rect ********
+ *
+ * Moves the source rectangle [i0, i1) x [j0, j1), halving its longer
+ * side until both sides are at most OBLIVIOUS_BASE
+ ************************/
+static void turn_rect(const struct turn *t, int i0, int i1, int j0, int j1)
+{
+        int w = i1 - i0, h = j1 - j0;
+
+        if (w <= OBLIVIOUS_BASE && h <= OBLIVIOUS_BASE) {
+                turn_tile(t, i0, i1, j0, j1);
+        } else if (w >= h) {
+                int mid = split(i0, w);
+                turn_rect(t, i0, mid, j0, j1);
+                turn_rect(t, mid, i1, j0, j1);
+        } else {
+                int mid = split(j0, h);
+                turn_rect(t, i0, i1, j0, mid);
+                turn_rect(t, i0, i1, mid, j1);
+        }
+}
+
+/********** turn ********
+ *
+ * Runs the recursion over all of a plain 'src' into plain 'dst' with
+ * the given mapping
+ ************************/
+static void turn(A2Methods_UArray2 src, A2Methods_UArray2 dst,
+                 int col0, int dcol, int row0, int drow)
+{
+        struct turn t;
+        t.src  = A2Inline_plain_view(src);
+        t.dst  = A2Inline_plain_view(dst);
+        t.col0 = col0;
+        t.dcol = dcol;
+        t.row0 = row0;
+        t.drow = drow;
+        t.tile = Tile_kernel_for(t.src.size);
+        assert(t.src.size == t.dst.size);
+        assert(t.dst.width == t.src.height && t.dst.height == t.src.width);
+
+        turn_rect(&t, 0, t.src.width, 0, t.src.height);
+}
+
+/********** Rotate_oblivious ********
+ *
+ * Transforms 'src' by 'op' into 'dst' without any cache-size
+ * parameter
+ *
+ * Parameters:
+ *      A2Methods_T methods:   suite that made both arrays
+ *      A2Methods_UArray2 src: source array
+ *      A2Methods_UArray2 dst: destination with the transformed
+ *                             dimensions and the same cell size
+ *      Rotate_op op:          which of the eight symmetries
+ *
+ * Return:
+ *      false if 'methods' is not the plain suite, else true
+ *
+ * Notes:
+ *      - the recursion bounds every subproblem by the caches it fits
+ *        in, whatever their sizes, so nothing is tuned per machine
+ *      - 1-, 2-, 3-, 4- and 8-byte cells go through the SIMD tile
+ *        kernels of tile.h
+ ************************/
+bool Rotate_oblivious(A2Methods_T methods, A2Methods_UArray2 src,
+                      A2Methods_UArray2 dst, Rotate_op op)
+{
+        assert(methods != NULL && src != NULL && dst != NULL);
+        if (methods != uarray2_methods_plain)
+                return false;
+        if (!(op & ROTATE_TRANSPOSE))
+                return Rotate_direct(methods, src, dst, op);
+
+        int width  = UArray2_width(src);
+        int height = UArray2_height(src);
+        bool fx = op & ROTATE_FLIP_X, fy = op & ROTATE_FLIP_Y;
+
+        turn(src, dst, fx ? height - 1 : 0, fx ? -1 : 1,
+                       fy ? width - 1  : 0, fy ? -1 : 1);
+        return true;
+}
+
+/*
+ * In-place transforms.  A grid addresses the cells of any suite, with
+ * the plain and blocked layouts computed inline.
+ */
+struct grid {
+        enum { GRID_PLAIN, GRID_BLOCKED, GRID_METHODS } kind;
+        A2Inline_plain    plain;
+        A2Inline_blocked  blocked;
+        A2Methods_T       methods;
+        A2Methods_UArray2 array;
+};
+
+static struct grid grid_of(A2Methods_T methods, A2Methods_UArray2 array)
+{
+        struct grid g;
+        g.methods = methods;
+        g.array   = array;
+        if (methods == uarray2_methods_plain) {
+                g.kind  = GRID_PLAIN;
+                g.plain = A2Inline_plain_view(array);
+        } else if (A2Blocked_is_blocked(methods)) {
+                g.kind    = GRID_BLOCKED;
+                g.blocked = A2Inline_blocked_view(array);
+        } else {
+                g.kind = GRID_METHODS;
+        }
+        return g;
+}
+
+static inline char *grid_at(const struct grid *g, int i, int j)
+{
+        switch (g->kind) {
+        case GRID_PLAIN:   return A2Inline_plain_at(&g->plain, i, j);
+        case GRID_BLOCKED: return A2Inline_blocked_at(&g->blocked, i, j);
+        default:           return g->methods->at(g->array, i, j);
+        }
+}
+
+/* copies one cell, with the common sizes as fixed-size moves */
+static inline void move_cell(char *dst, const char *src, int size)
+{
+        step_cells(dst, 0, src, 1, size);
+}
+
+/********** swap_pairs ********
+ *
+ * Applies 'op', which must not transpose, by swapping each cell with
+ * its mirror image; only the first half of the rows (vertical flip,
+ * 180) or of each row (horizontal flip) is walked
+ *
+ * Notes:
+ *      - plain rows are walked by pointer, one forward and its mirror
+ *        forward or backward
+ ************************/
+static void swap_pairs(const struct grid *g, Rotate_op op, int width,
+                       int height, int size)
+{
+        const bool fx = op & ROTATE_FLIP_X, fy = op & ROTATE_FLIP_Y;
+        const int rows = fy ? (height + 1) / 2 : height;
+        char *held = malloc(size);
+        assert(held != NULL);
+
+        for (int j = 0; j < rows; j++) {
+                int mirror = fy ? height - j - 1 : j;
+                if (mirror == j && !fx)
+                        continue;       /* middle row of a vertical flip */
+                int cols = mirror == j ? width / 2 : width;
+
+                if (g->kind == GRID_PLAIN) {
+                        char *p = grid_at(g, 0, j);
+                        char *q = grid_at(g, fx ? width - 1 : 0, mirror);
+                        ptrdiff_t step = fx ? -size : size;
+                        for (int i = 0; i < cols; i++, p += size,
+                                                     q += step) {
+                                move_cell(held, p, size);
+                                move_cell(p, q, size);
+                                move_cell(q, held, size);
+                        }
+                } else {
+                        for (int i = 0; i < cols; i++) {
+                                char *p = grid_at(g, i, j);
+                                char *q = grid_at(g, fx ? width - i - 1 : i,
+                                                  mirror);
+                                move_cell(held, p, size);
+                                move_cell(p, q, size);
+                                move_cell(q, held, size);
+                        }
+                }
+        }
+        free(held);
+}
+
+/* side of the square tiles the in-place permutation is visited in */
+#define INPLACE_TILE 16
+
+/********** permute ********
+ *
+ * Applies 'op', which must transpose, to the square n by n array
+ * behind 'g' by moving each orbit of cells around
+ *
+ * Notes:
+ *      - rotations have orbits of four cells, and every orbit but the
+ *        center has exactly one cell in the top-left quadrant; the
+ *        diagonal reflections have orbits of two, one on each side of
+ *        the diagonal.  Only that one cell per orbit is visited.
+ *      - visiting in tiles keeps the up to four tiles an orbit touches
+ *        in cache together
+ ************************/
+static void permute(const struct grid *g, Rotate_op op, int n, int size)
+{
+        const bool rotation = (op == ROTATE_90 || op == ROTATE_270);
+        const int len = rotation ? 4 : 2;
+        const int rows = rotation ? n / 2 : n;
+        char *held = malloc(size);
+        assert(held != NULL);
+
+        for (int tj = 0; tj < rows; tj += INPLACE_TILE) {
+                int tj1 = tj + INPLACE_TILE < rows ? tj + INPLACE_TILE
+                                                   : rows;
+                for (int ti = 0; ti < n; ti += INPLACE_TILE) {
+                        int ti1 = ti + INPLACE_TILE < n ? ti + INPLACE_TILE
+                                                        : n;
+                        for (int j = tj; j < tj1; j++) {
+                                /* the cells of row j that start an orbit */
+                                int lo = op == ROTATE_TRANSPOSE ? j + 1 : 0;
+                                int hi = rotation ? (n + 1) / 2
+                                       : op == ROTATE_TRANSVERSE ? n - j - 1
+                                       : n;
+                                if (lo < ti)  lo = ti;
+                                if (hi > ti1) hi = ti1;
+
+                                for (int i = lo; i < hi; i++) {
+                                        char *cell[4];
+                                        int c = i, r = j;
+                                        for (int k = 0; k < len; k++) {
+                                                cell[k] = grid_at(g, c, r);
+                                                dest_cell(op, c, r, n, n,
+                                                          &c, &r);
+                                        }
+                                        move_cell(held, cell[len - 1], size);
+                                        for (int k = len - 1; k > 0; k--)
+                                                move_cell(cell[k],
+                                                          cell[k - 1], size);
+                                        move_cell(cell[0], held, size);
+                                }
+                        }
+                }
+        }
+        free(held);
+}
+
+/********** Rotate_inplace ********
+ *
+ * Transforms 'array' by 'op' without a second array
+ *
+ * Parameters:
+ *      A2Methods_T methods:     suite that made 'array'
+ *      A2Methods_UArray2 array: the array, overwritten with the result
+ *      Rotate_op op:            which of the eight symmetries
+ *
+ * Return:
+ *      false if 'op' transposes a non-square array that is not plain,
+ *      else true
+ *
+ * Notes:
+ *      - a non-square transposing op is done as UArray2_transpose
+ *        followed by the flip that remains
+ ************************/
+bool Rotate_inplace(A2Methods_T methods, A2Methods_UArray2 array,
+                    Rotate_op op)
+{
+        assert(methods != NULL && array != NULL);
+        assert((unsigned)op < 8);
+
+        int width  = methods->width(array);
+        int height = methods->height(array);
+
+        if ((op & ROTATE_TRANSPOSE) && width != height) {
+                if (methods != uarray2_methods_plain)
+                        return false;
+                UArray2_transpose(array);
+                op = Rotate_compose(ROTATE_TRANSPOSE, op);
+                width  = methods->width(array);
+                height = methods->height(array);
+        }
+        if (op & ROTATE_TRANSPOSE) {
+                struct grid g = grid_of(methods, array);
+                permute(&g, op, width, methods->size(array));
+        } else if (op != ROTATE_0) {
+                struct grid g = grid_of(methods, array);
+                swap_pairs(&g, op, width, height, methods->size(array));
+        }
+        return true;
+}
@@ -0,0 +1,94 @@
+#ifndef ROTATE_INCLUDED
+#define ROTATE_INCLUDED
+
+/*
+ * Rotations, flips and transposes specialized for one storage layout,
+ * for callers that know the representation behind an A2Methods_T.
+ * Callers that only have the methods still go through methods->map.
+ */
+
+#include <stdbool.h>
+#include "a2methods.h"
+
+/*
+ * The eight symmetries of a rectangle, as bits.  Source cell (i, j)
+ * goes to the destination by first swapping i and j if
+ * ROTATE_TRANSPOSE is set, then mirroring the column (ROTATE_FLIP_X)
+ * and/or the row (ROTATE_FLIP_Y) within the destination.
+ */
+typedef enum Rotate_op {
+        ROTATE_FLIP_X    = 1,
+        ROTATE_FLIP_Y    = 2,
+        ROTATE_TRANSPOSE = 4,
+
+        ROTATE_0               = 0,
+        ROTATE_90              = ROTATE_TRANSPOSE | ROTATE_FLIP_X,
+        ROTATE_180             = ROTATE_FLIP_X | ROTATE_FLIP_Y,
+        ROTATE_270             = ROTATE_TRANSPOSE | ROTATE_FLIP_Y,
+        ROTATE_FLIP_HORIZONTAL = ROTATE_FLIP_X,
+        ROTATE_FLIP_VERTICAL   = ROTATE_FLIP_Y,
+        ROTATE_TRANSVERSE      = ROTATE_TRANSPOSE | ROTATE_FLIP_X
+                                                  | ROTATE_FLIP_Y
+} Rotate_op;
+
+/* the clockwise rotation by 'degrees' (0, 90, 180 or 270) */
+extern Rotate_op Rotate_degrees(int degrees);
+
+/* the single op equivalent to applying 'first' and then 'then' */
+extern Rotate_op Rotate_compose(Rotate_op first, Rotate_op then);
+
+/* "rotate 90", "flip horizontal", "transverse", ... */
+extern const char *Rotate_name(Rotate_op op);
+
+/* true if 'methods' is a plain or blocked (UArray2b) method suite */
+extern bool Rotate_has_layout(A2Methods_T methods);
+
+/*
+ * writes 'src' transformed by 'op' into 'dst'; both arrays come from
+ * 'methods' and hold cells of the same size, one of the pixfmt.h
+ * formats or the 1- or 2-byte samples of a plane, and 'dst' has the
+ * dimensions of 'src', swapped if 'op' includes ROTATE_TRANSPOSE.  The
+ * traversal is generated from a2inline.h with its kernel inlined, once
+ * per cell size.
+ *
+ * returns false, leaving 'dst' untouched, if 'methods' has no
+ * specialized layout or there is no kernel for the cell size
+ */
+extern bool Rotate_inline(A2Methods_T methods, A2Methods_UArray2 src,
+                          A2Methods_UArray2 dst, Rotate_op op);
+
+/*
+ * same contract as Rotate_inline, but cells may be of any size, and
+ * each run of source cells is copied along the matching destination
+ * line by pointer stepping (memcpy when the line runs forward); no
+ * per-cell index arithmetic or 'at' lookup is done
+ */
+extern bool Rotate_direct(A2Methods_T methods, A2Methods_UArray2 src,
+                          A2Methods_UArray2 dst, Rotate_op op);
+
+/*
+ * cache-oblivious version for plain arrays: when 'op' transposes, the
+ * source is split in half along its longer side until a tile is small
+ * enough for every cache, then the tile is moved by a tight loop (a
+ * SIMD tile transpose for 1-, 2-, 3-, 4- and 8-byte cells); other ops
+ * stream and go through Rotate_direct.  Same contract as Rotate_direct,
+ * except that only the plain suite is supported.
+ */
+extern bool Rotate_oblivious(A2Methods_T methods, A2Methods_UArray2 src,
+                             A2Methods_UArray2 dst, Rotate_op op);
+
+/*
+ * transforms 'array' by 'op' in place, with no second array: flips and
+ * 180 swap pairs of cells, transposing ops on square arrays move
+ * cycles of up to four cells, and transposing ops on non-square plain
+ * arrays follow the cycles of the transposition (see UArray2_transpose)
+ * and then swap.  Works for any suite and cell size.
+ *
+ * returns false, leaving 'array' untouched, if 'op' transposes a
+ * non-square array that is not plain; otherwise the width and height
+ * of 'array' are those of the result
+ */
+extern bool Rotate_inplace(A2Methods_T methods, A2Methods_UArray2 array,
+                           Rotate_op op);
+
+#endif
@@ -67,5 +67,21 @@ int main(void) {
         printf("\nArray not freed!\n");
     }
 
+    // Step 11: Test a view over caller memory (3x2 cells of 3 bytes at an
+    // odd address, as in a mapped raster): cells are found in place and
+    // freeing the view leaves the memory alone
+    unsigned char raster[1 + 3 * 2 * 3];
+    for (unsigned k = 0; k < sizeof(raster); k++) raster[k] = k;
+    A2Methods_UArray2 view = UArray2_view(3, 2, 3, raster + 1);
+    unsigned char *cell = methods->at(view, 1, 1);
+    printf("\nView cell (1, 1) at offset %d = %d\n",
+           (int)(cell - raster), *cell);
+    if (cell != raster + 1 + (1 * 3 + 1) * 3) {
+        printf("View cell misplaced!\n");
+        return EXIT_FAILURE;
+    }
+    methods->free(&view);
+    printf("View freed, raster intact: %d\n", raster[sizeof(raster) - 1]);
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,311 @@
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "pnm.h"
+#include "pixfmt.h"
+#include "ppmio.h"
+
+static int failures = 0;
+
+// a growing text buffer
+struct text {
+    char  *s;
+    size_t n, cap;
+};
+
+static void put(struct text *t, const char *fmt, ...) {
+    va_list ap;
+    for (;;) {
+        va_start(ap, fmt);
+        int k = vsnprintf(t->s + t->n, t->cap - t->n, fmt, ap);
+        va_end(ap);
+        if (t->n + k < t->cap) {
+            t->n += k;
+            return;
+        }
+        t->cap = 2 * t->cap + k + 1;
+        t->s = realloc(t->s, t->cap);
+    }
+}
+
+// what goes between two samples: whitespace of every kind, sometimes
+// a comment holding digits and '#'
+static void separator(struct text *t, int style) {
+    static const char *spaces[] = { " ", "\n", "\t", "\r\n", "  ", " \f",
+                                    "\v", "\r" };
+    if (style == 0) {
+        put(t, " ");
+        return;
+    }
+    int r = rand() % 100;
+    if (r < 4)
+        put(t, " # 12 #34\n");
+    else if (r < 6)
+        put(t, "#\n");
+    else
+        for (int k = 1 + rand() % 3; k > 0; k--)
+            put(t, "%s", spaces[rand() % 8]);
+}
+
+// a P3 image of random samples up to 'maxval', with 'pad' spaces
+// before the raster so that tokens fall at every offset in a window;
+// 'zeros' leading zeros on some samples make digit runs past 64 bytes
+static struct text p3(int width, int height, unsigned maxval, int pad,
+                      int style, int zeros, unsigned *samples) {
+    struct text t = { malloc(256), 0, 256 };
+    put(&t, "P3\n# made by test_ppmio\n%d %d\n%u\n", width, height, maxval);
+    for (int k = 0; k < pad; k++)
+        put(&t, " ");
+    for (int k = 0; k < 3 * width * height; k++) {
+        samples[k] = rand() % (maxval + 1);
+        if (zeros > 0 && rand() % 8 == 0)
+            put(&t, "%0*u", zeros + rand() % 8, samples[k]);
+        else
+            put(&t, "%u", samples[k]);
+        separator(&t, style);
+    }
+    return t;
+}
+
+// the image read from 'text' by the course reader
+static Pnm_ppm course_read(struct text *t) {
+    FILE *fp = fmemopen(t->s, t->n, "r");
+    Pnm_ppm image = Pnm_ppmread(fp, uarray2_methods_plain);
+    fclose(fp);
+    return image;
+}
+
+// the image read from 'text' by Ppmio_read (packed, or aligned), or by
+// Ppmio_read_wide if 'wide'
+static Pnm_ppm ppmio_read(struct text *t, A2Methods_T methods, int wide,
+                          int aligned, Pixfmt *fmt) {
+    FILE *fp = fmemopen(t->s, t->n, "r");
+    Pnm_ppm image;
+    if (wide) {
+        image = Ppmio_read_wide(fp, methods);
+        *fmt = PIXFMT_WIDE;
+    } else {
+        image = Ppmio_read(fp, methods, aligned, fmt);
+    }
+    fclose(fp);
+    return image;
+}
+
+// compares 'image', in 'fmt', with the course reader's 'expected' and
+// with the samples written
+static int same(const char *what, Pnm_ppm image, Pixfmt fmt,
+                Pnm_ppm expected, const unsigned *samples) {
+    if (image == NULL) {
+        printf("%s: not read\n", what);
+        return 0;
+    }
+    if (image->width != expected->width
+        || image->height != expected->height
+        || image->denominator != expected->denominator) {
+        printf("%s: header differs\n", what);
+        return 0;
+    }
+    for (unsigned j = 0; j < image->height; j++)
+        for (unsigned i = 0; i < image->width; i++) {
+            struct Pnm_rgb got, want;
+            Pixfmt_unpack(fmt, image->methods->at(image->pixels, i, j),
+                          &got);
+            want = *(struct Pnm_rgb *)expected->methods->at(
+                                          expected->pixels, i, j);
+            const unsigned *s = samples + 3 * (j * image->width + i);
+            if (got.red != want.red || got.green != want.green
+                || got.blue != want.blue || want.red != s[0]
+                || want.green != s[1] || want.blue != s[2]) {
+                printf("%s: pixel (%u, %u) is %u %u %u, not %u %u %u\n",
+                       what, i, j, got.red, got.green, got.blue, s[0],
+                       s[1], s[2]);
+                return 0;
+            }
+        }
+    return 1;
+}
+
+// compares the planes read as 'image' with the course reader's
+// 'expected'
+static int same_planes(const char *what, Pnm_ppm image,
+                       A2Methods_UArray2 planes[3], Pnm_ppm expected) {
+    if (image == NULL) {
+        printf("%s: not read\n", what);
+        return 0;
+    }
+    int size = image->methods->size(planes[0]);
+    if (image->pixels != planes[0]
+        || size != (expected->denominator > 255 ? 2 : 1)) {
+        printf("%s: planes are not as documented\n", what);
+        return 0;
+    }
+    for (unsigned j = 0; j < image->height; j++)
+        for (unsigned i = 0; i < image->width; i++) {
+            struct Pnm_rgb *want = expected->methods->at(expected->pixels,
+                                                         i, j);
+            unsigned wanted[3] = { want->red, want->green, want->blue };
+            for (int p = 0; p < 3; p++) {
+                void *cell = image->methods->at(planes[p], i, j);
+                unsigned got = size == 1 ? *(uint8_t *)cell
+                                         : *(uint16_t *)cell;
+                if (got != wanted[p]) {
+                    printf("%s: plane %d at (%u, %u) is %u, not %u\n",
+                           what, p, i, j, got, wanted[p]);
+                    return 0;
+                }
+            }
+        }
+    return 1;
+}
+
+// reads 'text' into planes, in plain and in blocked storage, and
+// compares them with the course reader; then writes the planes and
+// reads the output back with the course reader
+static void test_planes(struct text *t, Pnm_ppm expected,
+                        const unsigned *samples, const char *name) {
+    char what[160];
+    for (int blocked = 0; blocked < 2; blocked++) {
+        A2Methods_T methods = blocked ? uarray2_methods_blocked
+                                      : uarray2_methods_plain;
+        A2Methods_UArray2 planes[3];
+        FILE *fp = fmemopen(t->s, t->n, "r");
+        Pnm_ppm image = Ppmio_read_planes(fp, methods, planes);
+        fclose(fp);
+        snprintf(what, sizeof(what), "%s, %splanar", name,
+                 blocked ? "blocked " : "");
+        if (!same_planes(what, image, planes, expected))
+            failures++;
+        if (image == NULL)
+            continue;
+
+        FILE *out = tmpfile();
+        strncat(what, ", written", sizeof(what) - strlen(what) - 1);
+        if (!Ppmio_write_planes(out, image, planes)) {
+            printf("%s: not written\n", what);
+            failures++;
+        } else {
+            rewind(out);
+            Pnm_ppm back = Pnm_ppmread(out, uarray2_methods_plain);
+            if (!same(what, back, PIXFMT_WIDE, expected, samples))
+                failures++;
+            if (back != NULL)
+                Pnm_ppmfree(&back);
+        }
+        fclose(out);
+        methods->free(&planes[1]);
+        methods->free(&planes[2]);
+        Pnm_ppmfree(&image);
+    }
+}
+
+// reads one generated image every way and compares each with the
+// course reader
+void test_image(int width, int height, unsigned maxval, int pad,
+                int style, int zeros) {
+    unsigned *samples = malloc(sizeof(unsigned) * 3 * width * height);
+    struct text t = p3(width, height, maxval, pad, style, zeros, samples);
+    Pnm_ppm expected = course_read(&t);
+    char what[128];
+
+    for (int way = 0; way < 4; way++) {
+        A2Methods_T methods = way == 3 ? uarray2_methods_blocked
+                                       : uarray2_methods_plain;
+        Pixfmt fmt;
+        Pnm_ppm image = ppmio_read(&t, methods, way == 2 || way == 3,
+                                   way == 1, &fmt);
+        snprintf(what, sizeof(what), "%dx%d maxval %u pad %d style %d "
+                 "zeros %d, %s", width, height, maxval, pad, style, zeros,
+                 way == 3 ? "wide blocked" : Pixfmt_name(fmt));
+        if (!same(what, image, fmt, expected, samples))
+            failures++;
+        if (image != NULL)
+            Pnm_ppmfree(&image);
+    }
+    snprintf(what, sizeof(what), "%dx%d maxval %u pad %d style %d zeros %d",
+             width, height, maxval, pad, style, zeros);
+    test_planes(&t, expected, samples, what);
+    Pnm_ppmfree(&expected);
+    free(t.s);
+    free(samples);
+}
+
+// text that is not a whole P3 image must be refused: every cut short
+// of the last sample, and a stray byte inside the raster; text after
+// the last sample is ignored, as the course reader does
+void test_bad_input(void) {
+    unsigned samples[3 * 5 * 4];
+    struct text t = p3(5, 4, 1000, 0, 0, 0, samples);
+    size_t n = t.n, first = n;
+    while (first > 0 && !isdigit((unsigned char)t.s[first - 1]))
+        first--;
+    while (first > 0 && isdigit((unsigned char)t.s[first - 1]))
+        first--;                        // start of the last sample
+    size_t header = strstr(t.s, "\n1000\n") - t.s + 6;
+    Pixfmt fmt;
+
+    for (size_t cut = 1; cut <= first; cut++) {
+        t.n = cut;
+        Pnm_ppm image = ppmio_read(&t, uarray2_methods_plain, 0, 0, &fmt);
+        if (image != NULL) {
+            printf("input cut at %zu of %zu bytes was read\n", cut, n);
+            failures++;
+            Pnm_ppmfree(&image);
+            break;
+        }
+    }
+    t.n = n;
+
+    char *mid = strchr(t.s + header + 1, ' ');
+    if (mid != NULL) {
+        *mid = 'x';
+        Pnm_ppm image = ppmio_read(&t, uarray2_methods_plain, 0, 0, &fmt);
+        if (image != NULL) {
+            printf("stray byte in the raster was accepted\n");
+            failures++;
+            Pnm_ppmfree(&image);
+        }
+        *mid = ' ';
+    }
+
+    put(&t, "junk 12 # more\n");
+    Pnm_ppm image = ppmio_read(&t, uarray2_methods_plain, 0, 0, &fmt);
+    if (image == NULL) {
+        printf("text after the last sample was refused\n");
+        failures++;
+    } else {
+        Pnm_ppmfree(&image);
+    }
+    free(t.s);
+}
+
+int main(void) {
+    srand(40);
+
+    unsigned maxvals[] = { 1, 9, 255, 256, 1000, 65535 };
+    for (int m = 0; m < 6; m++) {
+        test_image(7, 5, maxvals[m], 0, 0, 0);
+        test_image(31, 17, maxvals[m], 3, 1, 0);
+        test_image(19, 23, maxvals[m], 5, 1, 60);    // runs past 64 bytes
+    }
+
+    // every offset of the raster within a 64-byte window, so that each
+    // kind of token straddles a window boundary
+    for (int pad = 0; pad < 64; pad++) {
+        test_image(13, 3, 255, pad, pad & 1, 0);
+        test_image(5, 4, 65535, pad, 1, pad % 3 ? 0 : 9);
+    }
+
+    // several text chunks, and tokens across the chunk boundaries
+    test_image(700, 120, 255, 0, 1, 0);
+    test_image(300, 200, 65535, 17, 1, 12);
+
+    test_bad_input();
+
+    printf(failures ? "FAILED\n" : "Passed.\n");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "rotate.h"
+#include "tile.h"
+
+static int failures = 0;
+
+// cell c of row r of a buffer of 'size'-byte cells, 24 cells a row
+static uint64_t cell(const unsigned char *base, int size, int r, int c) {
+    uint64_t v = 0;
+    memcpy(&v, base + (r * 24 + c) * size, size);
+    return v;
+}
+
+// transposes one tile of 'size'-byte cells with kernel 'k' (both
+// strides of each sign) and compares every cell with the definition
+void test_kernel(const Tile_kernel *k, int size) {
+    int n = k->side;
+    ptrdiff_t row = 24 * size;
+    unsigned char src[16 * 24 * 8], dst[16 * 24 * 8];
+    for (unsigned i = 0; i < sizeof(src); i++) src[i] = rand();
+
+    for (int flip = 0; flip < 4; flip++) {
+        int sdir = (flip & 1) ? -1 : 1, ddir = (flip & 2) ? -1 : 1;
+        int s0 = sdir > 0 ? 0 : n - 1, d0 = ddir > 0 ? 0 : n - 1;
+        k->transpose(src + s0 * row, sdir * row, dst + d0 * row,
+                     ddir * row);
+        for (int r = 0; r < n; r++)
+            for (int c = 0; c < n; c++)
+                if (cell(dst, size, d0 + ddir * c, r)
+                    != cell(src, size, s0 + sdir * r, c)) {
+                    printf("%s/%d: cell (%d, %d) wrong, strides %d %d\n",
+                           k->name, size * 8, r, c, sdir, ddir);
+                    failures++;
+                    return;
+                }
+    }
+
+    for (int len = 0; len <= 71; len++) {
+        k->reverse(src, dst, len);
+        for (int i = 0; i < len; i++)
+            if (cell(dst, size, 0, i) != cell(src, size, 0, len - 1 - i)) {
+                printf("%s/%d: reversal of %d cells wrong at %d\n",
+                       k->name, size * 8, len, i);
+                failures++;
+                return;
+            }
+    }
+    printf("%s/%d (%dx%d) ok\n", k->name, size * 8, n, n);
+}
+
+// transforms a width x height array of 'size'-byte cells and checks
+// where each cell landed; cells hold the low bytes of j * 65536 + i,
+// mixed so that 8-bit cells still tell neighbours apart
+void test_turn(int width, int height, Rotate_op op, int size) {
+    A2Methods_T methods = uarray2_methods_plain;
+    int swap = op & ROTATE_TRANSPOSE;
+    A2Methods_UArray2 src = methods->new(width, height, size);
+    A2Methods_UArray2 dst = methods->new(swap ? height : width,
+                                         swap ? width : height, size);
+
+    for (int j = 0; j < height; j++)
+        for (int i = 0; i < width; i++) {
+            uint64_t v = (j * 65536 + i + j * 7) * 0x100000001ull;
+            memcpy(methods->at(src, i, j), &v, size);
+        }
+
+    Rotate_oblivious(methods, src, dst, op);
+
+    int dw = methods->width(dst), dh = methods->height(dst);
+    for (int j = 0; j < height; j++)
+        for (int i = 0; i < width; i++) {
+            int col = swap ? j : i, row = swap ? i : j;
+            if (op & ROTATE_FLIP_X) col = dw - col - 1;
+            if (op & ROTATE_FLIP_Y) row = dh - row - 1;
+            uint64_t v = (j * 65536 + i + j * 7) * 0x100000001ull;
+            if (memcmp(methods->at(dst, col, row), &v, size) != 0) {
+                printf("%dx%d op %d, %d-byte cells: cell (%d, %d) "
+                       "misplaced\n", width, height, op, size, i, j);
+                failures++;
+                goto done;
+            }
+        }
+done:
+    methods->free(&src);
+    methods->free(&dst);
+}
+
+// applies every pair of ops in turn and checks that the composed op
+// gives the same array in one pass
+void test_compose(void) {
+    A2Methods_T methods = uarray2_methods_plain;
+    int width = 5, height = 3;
+    A2Methods_UArray2 src = methods->new(width, height, sizeof(uint32_t));
+    for (int j = 0; j < height; j++)
+        for (int i = 0; i < width; i++)
+            *(uint32_t *)methods->at(src, i, j) = j * width + i;
+
+    for (int a = 0; a < 8; a++)
+        for (int b = 0; b < 8; b++) {
+            int sa = a & ROTATE_TRANSPOSE, sb = b & ROTATE_TRANSPOSE;
+            int w1 = sa ? height : width, h1 = sa ? width : height;
+            int w2 = sb ? h1 : w1, h2 = sb ? w1 : h1;
+            A2Methods_UArray2 mid = methods->new(w1, h1, sizeof(uint32_t));
+            A2Methods_UArray2 two = methods->new(w2, h2, sizeof(uint32_t));
+            A2Methods_UArray2 one = methods->new(w2, h2, sizeof(uint32_t));
+
+            Rotate_oblivious(methods, src, mid, a);
+            Rotate_oblivious(methods, mid, two, b);
+            Rotate_oblivious(methods, src, one, Rotate_compose(a, b));
+
+            for (int j = 0; j < h2; j++)
+                for (int i = 0; i < w2; i++)
+                    if (*(uint32_t *)methods->at(one, i, j)
+                        != *(uint32_t *)methods->at(two, i, j)) {
+                        printf("%s then %s is not %s\n", Rotate_name(a),
+                               Rotate_name(b),
+                               Rotate_name(Rotate_compose(a, b)));
+                        failures++;
+                        i = w2;
+                        j = h2;
+                    }
+            methods->free(&mid);
+            methods->free(&two);
+            methods->free(&one);
+        }
+    methods->free(&src);
+}
+
+// transforms arrays in place and checks them against Rotate_direct
+void test_inplace(A2Methods_T methods, int width, int height, Rotate_op op) {
+    int swap = op & ROTATE_TRANSPOSE;
+    A2Methods_UArray2 a = methods->new(width, height, sizeof(uint32_t));
+    A2Methods_UArray2 b = methods->new(swap ? height : width,
+                                       swap ? width : height,
+                                       sizeof(uint32_t));
+    for (int j = 0; j < height; j++)
+        for (int i = 0; i < width; i++)
+            *(uint32_t *)methods->at(a, i, j) = j * 65536 + i;
+
+    Rotate_direct(methods, a, b, op);
+    if (!Rotate_inplace(methods, a, op)) {
+        printf("%dx%d op %d not done in place\n", width, height, op);
+        failures++;
+    } else if (methods->width(a) != methods->width(b)
+               || methods->height(a) != methods->height(b)) {
+        printf("%dx%d op %d: wrong shape in place\n", width, height, op);
+        failures++;
+    } else {
+        for (int j = 0; j < methods->height(b); j++)
+            for (int i = 0; i < methods->width(b); i++)
+                if (*(uint32_t *)methods->at(a, i, j)
+                    != *(uint32_t *)methods->at(b, i, j)) {
+                    printf("%dx%d op %d: (%d, %d) wrong in place\n",
+                           width, height, op, i, j);
+                    failures++;
+                    i = methods->width(b);
+                    j = methods->height(b);
+                }
+    }
+    methods->free(&a);
+    methods->free(&b);
+}
+
+int main(void) {
+    const char *names[] = { "avx2", "sse2", "ssse3", "scalar" };
+    const int cell_sizes[] = { 1, 2, 3, 4, 8 };
+    for (int s = 0; s < 5; s++)
+        for (int i = 0; i < 4; i++) {
+            int size = cell_sizes[s];
+            const Tile_kernel *k = Tile_kernel_named(size, names[i]);
+            // 3-byte cells have ssse3 and scalar kernels, the rest not ssse3
+            int exists = size == 3 ? i >= 2 : i != 2;
+            if (k != NULL)
+                test_kernel(k, size);
+            else if (exists)
+                printf("%s/%d not supported here\n", names[i], size * 8);
+        }
+    printf("using %s\n", Tile_kernel_for(4)->name);
+
+    int sizes[][2] = { {1, 1}, {8, 8}, {16, 16}, {17, 33}, {100, 37},
+                       {37, 100}, {256, 3}, {300, 211} };
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (int op = 0; op < 8; op++)
+            for (int c = 0; c < 5; c++)
+                test_turn(sizes[s][0], sizes[s][1], op, cell_sizes[c]);
+    }
+
+    test_compose();
+
+    for (int op = 0; op < 8; op++) {
+        test_inplace(uarray2_methods_plain, 37, 100, op);
+        test_inplace(uarray2_methods_plain, 1, 5, op);
+        test_inplace(uarray2_methods_plain, 33, 33, op);
+        test_inplace(uarray2_methods_blocked, 33, 33, op);
+        test_inplace(uarray2_methods_blocked, 300, 300, op);
+        if (!(op & ROTATE_TRANSPOSE))
+            test_inplace(uarray2_methods_blocked, 100, 37, op);
+    }
+
+    printf(failures ? "FAILED\n" : "Passed.\n");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
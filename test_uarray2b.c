@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "uarray2b.h"
+#include "cacheinfo.h"
 #include <assert.h>
 
 // Function to apply in UArray2b_map
@@ -11,6 +12,14 @@ void apply_function(int col, int row, UArray2b_T array2b, void *elem, void *cl)
     printf("Element at (%d, %d): %d\n", col, row, *val);
 }
 
+// Checks each element holds row * width + col and counts visits
+void count_and_check(int col, int row, UArray2b_T array2b, void *elem,
+                     void *cl) {
+    int *count = (int *)cl;
+    assert(*(int *)elem == row * UArray2b_width(array2b) + col);
+    (*count)++;
+}
+
 // Test UArray2b_new and related functions
 void test_new_and_basic_functions() {
     printf("Testing UArray2b_new and basic functions...\n");
@@ -78,6 +87,129 @@ void test_new_64K_block() {
     printf("UArray2b_new_64K_block test passed.\n\n");
 }
 
+// Test UArray2b_new_64K_pow2_block and the shift-based paths
+void test_new_64K_pow2_block() {
+    printf("Testing UArray2b_new_64K_pow2_block...\n");
+
+    // 12-byte elements would give 73 without rounding
+    int width = 150, height = 70, size = 12;
+    UArray2b_T array2b = UArray2b_new_64K_pow2_block(width, height, size);
+    assert(UArray2b_blocksize(array2b) == 64);
+
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            int *val = UArray2b_at(array2b, col, row);
+            *val = row * width + col;
+        }
+    }
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            int *val = UArray2b_at_pow2(array2b, col, row);
+            assert(*val == row * width + col);
+        }
+    }
+
+    int count = 0;
+    UArray2b_map(array2b, count_and_check, &count);
+    assert(count == width * height);
+
+    UArray2b_free(&array2b);
+    assert(array2b == NULL);
+
+    printf("UArray2b_new_64K_pow2_block test passed.\n\n");
+}
+
+// Test UArray2b_new_cache_block
+void test_new_cache_block() {
+    printf("Testing UArray2b_new_cache_block...\n");
+
+    int width = 300, height = 200, size = 12;
+    UArray2b_T array2b = UArray2b_new_cache_block(width, height, size);
+    int blocksize = UArray2b_blocksize(array2b);
+    printf("Cache block bytes %ld give blocksize %d\n", Cache_block_bytes(),
+           blocksize);
+    assert(blocksize >= 1);
+    assert((long)blocksize * blocksize * size <= Cache_block_bytes()
+           || blocksize == 1);
+
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            int *val = UArray2b_at(array2b, col, row);
+            *val = row * width + col;
+        }
+    }
+    int count = 0;
+    UArray2b_map(array2b, count_and_check, &count);
+    assert(count == width * height);
+
+    UArray2b_free(&array2b);
+    printf("UArray2b_new_cache_block test passed.\n\n");
+}
+
+// Checks every cell of a block against its position and counts cells
+void check_block(int col, int row, int width, int height, void *base,
+                 int stride, void *cl) {
+    int *count = (int *)cl;
+    for (int r = 0; r < height; r++) {
+        int *cell = (int *)((char *)base + r * stride);
+        for (int c = 0; c < width; c++) {
+            assert(cell[c] == (row + r) * 7 + (col + c));
+            (*count)++;
+        }
+    }
+}
+
+// Test UArray2b_map_blocks, including partial edge blocks
+void test_map_blocks() {
+    printf("Testing UArray2b_map_blocks...\n");
+
+    int width = 7, height = 7, blocksize = 3;
+    UArray2b_T array2b = UArray2b_new(width, height, sizeof(int), blocksize);
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            *(int *)UArray2b_at(array2b, col, row) = row * width + col;
+        }
+    }
+
+    int count = 0;
+    UArray2b_map_blocks(array2b, check_block, &count);
+    assert(count == width * height);
+
+    UArray2b_free(&array2b);
+    printf("UArray2b_map_blocks test passed.\n\n");
+}
+
+// Test rectangular blocks, including the cache-line-shaped constructor
+void test_new_rect() {
+    printf("Testing UArray2b_new_rect...\n");
+
+    int width = 37, height = 23;
+    int shapes[][2] = { { 16, 4 }, { 5, 3 }, { 8, 2 }, { 1, 7 } };
+    for (int s = 0; s < 4; s++) {
+        UArray2b_T array2b = UArray2b_new_rect(width, height, sizeof(int),
+                                               shapes[s][0], shapes[s][1]);
+        assert(UArray2b_block_width(array2b) == shapes[s][0]);
+        assert(UArray2b_block_height(array2b) == shapes[s][1]);
+        for (int row = 0; row < height; row++) {
+            for (int col = 0; col < width; col++) {
+                *(int *)UArray2b_at(array2b, col, row) = row * width + col;
+            }
+        }
+        int count = 0;
+        UArray2b_map(array2b, count_and_check, &count);
+        assert(count == width * height);
+        UArray2b_free(&array2b);
+    }
+
+    UArray2b_T array2b = UArray2b_new_64K_line_block(300, 200, 12);
+    assert(UArray2b_block_width(array2b) * 12 % 64 == 0);
+    assert(UArray2b_block_width(array2b) * UArray2b_block_height(array2b)
+           * 12 <= 64 * 1024);
+    UArray2b_free(&array2b);
+
+    printf("UArray2b_new_rect test passed.\n\n");
+}
+
 // Test UArray2b_map to ensure correct iteration
 void test_map_function() {
     printf("Testing UArray2b_map...\n");
@@ -132,8 +264,12 @@ void test_edge_cases() {
 int main() {
     test_new_and_basic_functions();
     test_new_64K_block();
+    test_new_64K_pow2_block();
+    test_new_cache_block();
     test_map_function();
     test_edge_cases();
+    test_map_blocks();
+    test_new_rect();
 
     printf("All tests passed successfully.\n");
     return 0;
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "uarray2m.h"
+#include <assert.h>
+
+// Cells allocated for 'array2m': whole tiles, padding included
+static size_t cells_allocated(UArray2m_T array2m) {
+    size_t tile = UArray2m_tilesize(array2m);
+    size_t wide = (UArray2m_width(array2m) + tile - 1) / tile;
+    size_t high = (UArray2m_height(array2m) + tile - 1) / tile;
+    return wide * high * tile * tile;
+}
+
+// Checks each element holds row * width + col and counts visits
+void count_and_check(int col, int row, UArray2m_T array2m, void *elem,
+                     void *cl) {
+    int *count = (int *)cl;
+    assert(*(int *)elem == row * UArray2m_width(array2m) + col);
+    (*count)++;
+}
+
+// Fills 'array2m' through UArray2m_at and checks that UArray2m_map
+// visits every cell once and sees the same values
+static void fill_and_map(UArray2m_T array2m) {
+    int width = UArray2m_width(array2m);
+    int height = UArray2m_height(array2m);
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            *(int *)UArray2m_at(array2m, col, row) = row * width + col;
+        }
+    }
+    int count = 0;
+    UArray2m_map(array2m, count_and_check, &count);
+    assert(count == width * height);
+}
+
+// Test UArray2m_new and related functions
+void test_new_and_basic_functions() {
+    printf("Testing UArray2m_new and basic functions...\n");
+
+    int width = 37, height = 21, size = sizeof(int);
+    UArray2m_T array2m = UArray2m_new(width, height, size);
+
+    assert(UArray2m_width(array2m) == width);
+    assert(UArray2m_height(array2m) == height);
+    assert(UArray2m_size(array2m) == size);
+    fill_and_map(array2m);
+
+    UArray2m_free(&array2m);
+    assert(array2m == NULL);
+
+    printf("UArray2m_new and basic functions test passed.\n\n");
+}
+
+// Test that padding stays below one tile edge of the shorter side, so
+// that a 1xN or Nx1 array takes O(N) cells
+void test_thin_arrays() {
+    printf("Testing padding of thin arrays...\n");
+
+    int lengths[] = { 10000, 1000000 };
+    for (int k = 0; k < 2; k++) {
+        int n = lengths[k];
+
+        UArray2m_T array2m = UArray2m_new(1, n, sizeof(int));
+        assert(UArray2m_tilesize(array2m) == 1);
+        assert(cells_allocated(array2m) == (size_t)n);
+        fill_and_map(array2m);
+        UArray2m_free(&array2m);
+
+        array2m = UArray2m_new(n, 1, sizeof(int));
+        assert(UArray2m_tilesize(array2m) == 1);
+        assert(cells_allocated(array2m) == (size_t)n);
+        fill_and_map(array2m);
+        UArray2m_free(&array2m);
+
+        array2m = UArray2m_new(3, n, sizeof(int));
+        assert(cells_allocated(array2m) <= (size_t)2 * 4 * n);
+        fill_and_map(array2m);
+        UArray2m_free(&array2m);
+    }
+
+    // a big square still uses the largest tile, padded by less than one
+    UArray2m_T array2m = UArray2m_new(1000, 700, sizeof(int));
+    assert(UArray2m_tilesize(array2m) == 256);
+    assert(cells_allocated(array2m) == (size_t)1024 * 768);
+    fill_and_map(array2m);
+    UArray2m_free(&array2m);
+
+    printf("Thin arrays test passed.\n\n");
+}
+
+int main() {
+    test_new_and_basic_functions();
+    test_thin_arrays();
+
+    printf("All tests passed successfully.\n");
+    return 0;
+}
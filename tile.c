@@ -0,0 +1,698 @@
+/**************************************************************
+ *
+ *                     tile.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall
+ *     Date:       October 7, 2024
+ *
+ *     Tile transposes and run reversal of 8-, 16-, 24-, 32- and 64-bit
+ *     cells.
+ *     The vector kernels are compiled with per-function target
+ *     attributes, so the program still runs on CPUs without AVX2;
+ *     which kernel is used is decided once from the CPU's feature
+ *     flags.
+ *
+ **************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tile.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TILE_X86 1
+#endif
+
+typedef uint32_t Cell;
+
+/*
+ * Portable kernels for cells of BITS bits: a SIDE x SIDE transpose and
+ * a run reversal, one cell at a time
+ */
+#define SCALAR_KERNELS(BITS, SIDE)                                      \
+static void transpose##SIDE##_scalar##BITS(const void *src,             \
+                                           ptrdiff_t src_stride,        \
+                                           void *dst,                   \
+                                           ptrdiff_t dst_stride)        \
+{                                                                       \
+        for (int r = 0; r < SIDE; r++) {                                \
+                const uint##BITS##_t *in = (const uint##BITS##_t *)     \
+                        ((const char *)src + r * src_stride);           \
+                for (int c = 0; c < SIDE; c++)                          \
+                        ((uint##BITS##_t *)((char *)dst                 \
+                                            + c * dst_stride))[r]       \
+                                = in[c];                                \
+        }                                                               \
+}                                                                       \
+                                                                        \
+static void reverse_scalar##BITS(const void *src, void *dst, int n)     \
+{                                                                       \
+        const uint##BITS##_t *s = src;                                  \
+        uint##BITS##_t *d = dst;                                        \
+        for (int k = 0; k < n; k++)                                     \
+                d[k] = s[n - 1 - k];                                    \
+}
+
+SCALAR_KERNELS(8, 8)
+SCALAR_KERNELS(16, 8)
+SCALAR_KERNELS(32, 4)
+SCALAR_KERNELS(64, 4)
+
+/*
+ * Portable kernels for 3-byte (packed RGB8) cells, which have no
+ * integer type: each cell is a 3-byte memcpy
+ */
+static void transpose8_scalar24(const void *src, ptrdiff_t src_stride,
+                                void *dst, ptrdiff_t dst_stride)
+{
+        for (int r = 0; r < 8; r++) {
+                const char *in = (const char *)src + r * src_stride;
+                for (int c = 0; c < 8; c++)
+                        memcpy((char *)dst + c * dst_stride + 3 * r,
+                               in + 3 * c, 3);
+        }
+}
+
+static void reverse_scalar24(const void *src, void *dst, int n)
+{
+        const char *s = src;
+        char *d = dst;
+        for (int k = 0; k < n; k++)
+                memcpy(d + 3 * k, s + 3 * (n - 1 - k), 3);
+}
+
+#ifdef TILE_X86
+
+#define ROW(base, stride, r) ((base) + (r) * (stride))
+
+/********** transpose4_sse2 ********
+ *
+ * 4x4 transpose in four xmm registers: interleave 32-bit cells of row
+ * pairs, then 64-bit halves
+ ************************/
+__attribute__((target("sse2")))
+static void transpose4_sse2(const void *src, ptrdiff_t src_stride,
+                            void *dst, ptrdiff_t dst_stride)
+{
+        const char *s = src;
+        char *d = dst;
+
+        __m128i r0 = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, 0));
+        __m128i r1 = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, 1));
+        __m128i r2 = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, 2));
+        __m128i r3 = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, 3));
+
+        __m128i t0 = _mm_unpacklo_epi32(r0, r1);    /* a0 b0 a1 b1 */
+        __m128i t1 = _mm_unpacklo_epi32(r2, r3);    /* c0 d0 c1 d1 */
+        __m128i t2 = _mm_unpackhi_epi32(r0, r1);    /* a2 b2 a3 b3 */
+        __m128i t3 = _mm_unpackhi_epi32(r2, r3);    /* c2 d2 c3 d3 */
+
+        _mm_storeu_si128((__m128i *)ROW(d, dst_stride, 0),
+                         _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)ROW(d, dst_stride, 1),
+                         _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128((__m128i *)ROW(d, dst_stride, 2),
+                         _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128((__m128i *)ROW(d, dst_stride, 3),
+                         _mm_unpackhi_epi64(t2, t3));
+}
+
+/********** transpose8_avx2 ********
+ *
+ * 8x8 transpose in eight ymm registers: the 4x4 steps run in both
+ * 128-bit lanes at once, then the lanes are exchanged
+ ************************/
+__attribute__((target("avx2")))
+static void transpose8_avx2(const void *src, ptrdiff_t src_stride,
+                            void *dst, ptrdiff_t dst_stride)
+{
+        const char *s = src;
+        char *d = dst;
+        __m256i r[8], t[8], u[8];
+
+        for (int k = 0; k < 8; k++)
+                r[k] = _mm256_loadu_si256((const __m256i *)
+                                          ROW(s, src_stride, k));
+
+        for (int k = 0; k < 8; k += 2) {
+                t[k]     = _mm256_unpacklo_epi32(r[k], r[k + 1]);
+                t[k + 1] = _mm256_unpackhi_epi32(r[k], r[k + 1]);
+        }
+        for (int k = 0; k < 8; k += 4) {
+                u[k]     = _mm256_unpacklo_epi64(t[k],     t[k + 2]);
+                u[k + 1] = _mm256_unpackhi_epi64(t[k],     t[k + 2]);
+                u[k + 2] = _mm256_unpacklo_epi64(t[k + 1], t[k + 3]);
+                u[k + 3] = _mm256_unpackhi_epi64(t[k + 1], t[k + 3]);
+        }
+        for (int k = 0; k < 4; k++) {
+                _mm256_storeu_si256((__m256i *)ROW(d, dst_stride, k),
+                        _mm256_permute2x128_si256(u[k], u[k + 4], 0x20));
+                _mm256_storeu_si256((__m256i *)ROW(d, dst_stride, k + 4),
+                        _mm256_permute2x128_si256(u[k], u[k + 4], 0x31));
+        }
+}
+
+/********** reverse_sse2 ********
+ *
+ * Run reversal four cells at a time: load from the end of the source,
+ * reverse the register, store at the front of the destination
+ ************************/
+__attribute__((target("sse2")))
+static void reverse_sse2(const void *src, void *dst, int n)
+{
+        const Cell *s = src;
+        Cell *d = dst;
+        int k = 0;
+
+        for (; k + 4 <= n; k += 4) {
+                __m128i x = _mm_loadu_si128((const __m128i *)(s + n - k - 4));
+                _mm_storeu_si128((__m128i *)(d + k),
+                                 _mm_shuffle_epi32(x, 0x1B));
+        }
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/********** reverse_avx2 ********
+ *
+ * Run reversal eight cells at a time with a cross-lane permute
+ ************************/
+__attribute__((target("avx2")))
+static void reverse_avx2(const void *src, void *dst, int n)
+{
+        const Cell *s = src;
+        Cell *d = dst;
+        const __m256i backwards = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        int k = 0;
+
+        for (; k + 8 <= n; k += 8) {
+                __m256i x = _mm256_loadu_si256((const __m256i *)
+                                               (s + n - k - 8));
+                _mm256_storeu_si256((__m256i *)(d + k),
+                        _mm256_permutevar8x32_epi32(x, backwards));
+        }
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/********** interleave ********
+ *
+ * One step of a register transpose over the rows r[0..n): rows 2k and
+ * 2k + 1 are interleaved in units of 'bits' bits, the low halves going
+ * to r[k] and the high halves to r[k + n / 2].  log2(n) steps with
+ * doubling units leave column c in r[bit reversal of c].
+ ************************/
+__attribute__((target("sse2")))
+static inline void interleave(__m128i *r, int n, int bits)
+{
+        __m128i t[16];
+
+        for (int k = 0; k < n / 2; k++) {
+                __m128i a = r[2 * k], b = r[2 * k + 1];
+                switch (bits) {
+                case 8:
+                        t[k]         = _mm_unpacklo_epi8(a, b);
+                        t[k + n / 2] = _mm_unpackhi_epi8(a, b);
+                        break;
+                case 16:
+                        t[k]         = _mm_unpacklo_epi16(a, b);
+                        t[k + n / 2] = _mm_unpackhi_epi16(a, b);
+                        break;
+                case 32:
+                        t[k]         = _mm_unpacklo_epi32(a, b);
+                        t[k + n / 2] = _mm_unpackhi_epi32(a, b);
+                        break;
+                default:
+                        t[k]         = _mm_unpacklo_epi64(a, b);
+                        t[k + n / 2] = _mm_unpackhi_epi64(a, b);
+                        break;
+                }
+        }
+        for (int k = 0; k < n; k++)
+                r[k] = t[k];
+}
+
+/* the four-bit index 'c' reversed, for the outputs of interleave */
+static const int bit_reversed[16] = {
+        0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15
+};
+
+/********** transpose16_sse2_8 ********
+ *
+ * 16x16 byte transpose in sixteen xmm registers: interleave bytes,
+ * then 16-, 32- and 64-bit units
+ ************************/
+__attribute__((target("sse2")))
+static void transpose16_sse2_8(const void *src, ptrdiff_t src_stride,
+                               void *dst, ptrdiff_t dst_stride)
+{
+        const char *s = src;
+        char *d = dst;
+        __m128i r[16];
+
+        for (int k = 0; k < 16; k++)
+                r[k] = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, k));
+        for (int bits = 8; bits <= 64; bits *= 2)
+                interleave(r, 16, bits);
+        for (int c = 0; c < 16; c++)
+                _mm_storeu_si128((__m128i *)ROW(d, dst_stride, c),
+                                 r[bit_reversed[c]]);
+}
+
+/********** transpose8_sse2_16 ********
+ *
+ * 8x8 transpose of 16-bit cells: interleave 16-, 32- and 64-bit units
+ ************************/
+__attribute__((target("sse2")))
+static void transpose8_sse2_16(const void *src, ptrdiff_t src_stride,
+                               void *dst, ptrdiff_t dst_stride)
+{
+        const char *s = src;
+        char *d = dst;
+        __m128i r[8];
+
+        for (int k = 0; k < 8; k++)
+                r[k] = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, k));
+        for (int bits = 16; bits <= 64; bits *= 2)
+                interleave(r, 8, bits);
+        for (int c = 0; c < 8; c++)                /* 3-bit reversal */
+                _mm_storeu_si128((__m128i *)ROW(d, dst_stride, c),
+                                 r[bit_reversed[c] >> 1]);
+}
+
+/********** reverse16 ********
+ *
+ * The eight 16-bit units of 'x' in reverse order
+ ************************/
+__attribute__((target("sse2")))
+static inline __m128i reverse16(__m128i x)
+{
+        x = _mm_shuffle_epi32(x, 0x1B);
+        x = _mm_shufflelo_epi16(x, 0xB1);
+        return _mm_shufflehi_epi16(x, 0xB1);
+}
+
+/********** reverse_sse2_8 ********
+ *
+ * Byte run reversal sixteen at a time: reverse the 16-bit units, then
+ * swap the bytes of each
+ ************************/
+__attribute__((target("sse2")))
+static void reverse_sse2_8(const void *src, void *dst, int n)
+{
+        const uint8_t *s = src;
+        uint8_t *d = dst;
+        int k = 0;
+
+        for (; k + 16 <= n; k += 16) {
+                __m128i x = reverse16(_mm_loadu_si128((const __m128i *)
+                                                      (s + n - k - 16)));
+                _mm_storeu_si128((__m128i *)(d + k),
+                                 _mm_or_si128(_mm_slli_epi16(x, 8),
+                                              _mm_srli_epi16(x, 8)));
+        }
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/********** reverse_sse2_16 ********
+ *
+ * 16-bit run reversal eight at a time
+ ************************/
+__attribute__((target("sse2")))
+static void reverse_sse2_16(const void *src, void *dst, int n)
+{
+        const uint16_t *s = src;
+        uint16_t *d = dst;
+        int k = 0;
+
+        for (; k + 8 <= n; k += 8)
+                _mm_storeu_si128((__m128i *)(d + k),
+                                 reverse16(_mm_loadu_si128((const __m128i *)
+                                                           (s + n - k - 8))));
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/********** reverse_avx2_8 ********
+ *
+ * Byte run reversal 32 at a time: reverse within each 128-bit lane by
+ * a byte shuffle, then exchange the lanes
+ ************************/
+__attribute__((target("avx2")))
+static void reverse_avx2_8(const void *src, void *dst, int n)
+{
+        const uint8_t *s = src;
+        uint8_t *d = dst;
+        const __m256i backwards = _mm256_setr_epi8(
+                15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        int k = 0;
+
+        for (; k + 32 <= n; k += 32) {
+                __m256i x = _mm256_loadu_si256((const __m256i *)
+                                               (s + n - k - 32));
+                x = _mm256_shuffle_epi8(x, backwards);
+                _mm256_storeu_si256((__m256i *)(d + k),
+                                    _mm256_permute4x64_epi64(x, 0x4E));
+        }
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/********** reverse_avx2_16 ********
+ *
+ * 16-bit run reversal sixteen at a time, as reverse_avx2_8
+ ************************/
+__attribute__((target("avx2")))
+static void reverse_avx2_16(const void *src, void *dst, int n)
+{
+        const uint16_t *s = src;
+        uint16_t *d = dst;
+        const __m256i backwards = _mm256_setr_epi8(
+                14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+                14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+        int k = 0;
+
+        for (; k + 16 <= n; k += 16) {
+                __m256i x = _mm256_loadu_si256((const __m256i *)
+                                               (s + n - k - 16));
+                x = _mm256_shuffle_epi8(x, backwards);
+                _mm256_storeu_si256((__m256i *)(d + k),
+                                    _mm256_permute4x64_epi64(x, 0x4E));
+        }
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/********** transpose2_sse2_64 ********
+ *
+ * 2x2 transpose of 64-bit cells: the low and the high halves of the
+ * two rows
+ ************************/
+__attribute__((target("sse2")))
+static void transpose2_sse2_64(const void *src, ptrdiff_t src_stride,
+                               void *dst, ptrdiff_t dst_stride)
+{
+        const char *s = src;
+        char *d = dst;
+
+        __m128i r0 = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, 0));
+        __m128i r1 = _mm_loadu_si128((const __m128i *)ROW(s, src_stride, 1));
+        _mm_storeu_si128((__m128i *)ROW(d, dst_stride, 0),
+                         _mm_unpacklo_epi64(r0, r1));
+        _mm_storeu_si128((__m128i *)ROW(d, dst_stride, 1),
+                         _mm_unpackhi_epi64(r0, r1));
+}
+
+/********** transpose4_avx2_64 ********
+ *
+ * 4x4 transpose of 64-bit cells: interleave row pairs within the
+ * 128-bit lanes, then exchange the lanes
+ ************************/
+__attribute__((target("avx2")))
+static void transpose4_avx2_64(const void *src, ptrdiff_t src_stride,
+                               void *dst, ptrdiff_t dst_stride)
+{
+        const char *s = src;
+        char *d = dst;
+        __m256i r[4];
+
+        for (int k = 0; k < 4; k++)
+                r[k] = _mm256_loadu_si256((const __m256i *)
+                                          ROW(s, src_stride, k));
+
+        __m256i t0 = _mm256_unpacklo_epi64(r[0], r[1]);  /* a0 b0 a2 b2 */
+        __m256i t1 = _mm256_unpackhi_epi64(r[0], r[1]);  /* a1 b1 a3 b3 */
+        __m256i t2 = _mm256_unpacklo_epi64(r[2], r[3]);  /* c0 d0 c2 d2 */
+        __m256i t3 = _mm256_unpackhi_epi64(r[2], r[3]);  /* c1 d1 c3 d3 */
+
+        _mm256_storeu_si256((__m256i *)ROW(d, dst_stride, 0),
+                            _mm256_permute2x128_si256(t0, t2, 0x20));
+        _mm256_storeu_si256((__m256i *)ROW(d, dst_stride, 1),
+                            _mm256_permute2x128_si256(t1, t3, 0x20));
+        _mm256_storeu_si256((__m256i *)ROW(d, dst_stride, 2),
+                            _mm256_permute2x128_si256(t0, t2, 0x31));
+        _mm256_storeu_si256((__m256i *)ROW(d, dst_stride, 3),
+                            _mm256_permute2x128_si256(t1, t3, 0x31));
+}
+
+/********** reverse_sse2_64 ********
+ *
+ * 64-bit run reversal two at a time
+ ************************/
+__attribute__((target("sse2")))
+static void reverse_sse2_64(const void *src, void *dst, int n)
+{
+        const uint64_t *s = src;
+        uint64_t *d = dst;
+        int k = 0;
+
+        for (; k + 2 <= n; k += 2) {
+                __m128i x = _mm_loadu_si128((const __m128i *)(s + n - k - 2));
+                _mm_storeu_si128((__m128i *)(d + k),
+                                 _mm_shuffle_epi32(x, 0x4E));
+        }
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/********** reverse_avx2_64 ********
+ *
+ * 64-bit run reversal four at a time with a cross-lane permute
+ ************************/
+__attribute__((target("avx2")))
+static void reverse_avx2_64(const void *src, void *dst, int n)
+{
+        const uint64_t *s = src;
+        uint64_t *d = dst;
+        int k = 0;
+
+        for (; k + 4 <= n; k += 4) {
+                __m256i x = _mm256_loadu_si256((const __m256i *)
+                                               (s + n - k - 4));
+                _mm256_storeu_si256((__m256i *)(d + k),
+                                    _mm256_permute4x64_epi64(x, 0x1B));
+        }
+        for (; k < n; k++)
+                d[k] = s[n - 1 - k];
+}
+
+/*
+ * 3-byte cells are widened to 4 bytes in registers, moved by the
+ * 32-bit kernels' interleaves, and narrowed again on the way out.
+ * Loads and stores stay inside the 24 bytes of each tile row, so
+ * neighbouring tiles and the ends of the array are never touched.
+ */
+
+/* pshufb masks: cells 0-3 of bytes 0-15, cells 4-7 of bytes 8-23, and
+ * four 4-byte cells back to 12 bytes
+ */
+#define WIDEN_LO _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,                \
+                               6, 7, 8, -1, 9, 10, 11, -1)
+#define WIDEN_HI _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1,                \
+                               10, 11, 12, -1, 13, 14, 15, -1)
+#define NARROW   _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,  \
+                               -1, -1, -1, -1)
+
+/********** transpose4_regs ********
+ *
+ * transpose4_sse2 on four registers in place
+ ************************/
+__attribute__((target("ssse3")))
+static inline void transpose4_regs(__m128i *r)
+{
+        __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+        __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+        __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+        __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+
+        r[0] = _mm_unpacklo_epi64(t0, t1);
+        r[1] = _mm_unpackhi_epi64(t0, t1);
+        r[2] = _mm_unpacklo_epi64(t2, t3);
+        r[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* stores the low 12 bytes of 'x' at 'p' */
+__attribute__((target("ssse3")))
+static inline void store12(char *p, __m128i x)
+{
+        int high = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+        _mm_storel_epi64((__m128i *)p, x);
+        memcpy(p + 8, &high, 4);
+}
+
+/********** transpose8_ssse3_24 ********
+ *
+ * 8x8 transpose of 3-byte cells: each source row becomes two registers
+ * of four widened cells, the four 4x4 quarters are transposed, and
+ * each destination row is narrowed from two of them
+ ************************/
+__attribute__((target("ssse3")))
+static void transpose8_ssse3_24(const void *src, ptrdiff_t src_stride,
+                                void *dst, ptrdiff_t dst_stride)
+{
+        const char *s = src;
+        char *d = dst;
+        __m128i lo[8], hi[8];           /* cells 0-3 and 4-7 of a row */
+
+        for (int r = 0; r < 8; r++) {
+                const char *row = ROW(s, src_stride, r);
+                lo[r] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+                                                         row), WIDEN_LO);
+                hi[r] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+                                                         (row + 8)),
+                                         WIDEN_HI);
+        }
+        transpose4_regs(lo);
+        transpose4_regs(lo + 4);
+        transpose4_regs(hi);
+        transpose4_regs(hi + 4);
+
+        /* column c of the tile is lo[c], lo[c + 4] for c < 4, and
+         * hi[c - 4], hi[c] after */
+        for (int c = 0; c < 4; c++) {
+                char *row = ROW(d, dst_stride, c);
+                store12(row,      _mm_shuffle_epi8(lo[c],     NARROW));
+                store12(row + 12, _mm_shuffle_epi8(lo[c + 4], NARROW));
+                row = ROW(d, dst_stride, c + 4);
+                store12(row,      _mm_shuffle_epi8(hi[c],     NARROW));
+                store12(row + 12, _mm_shuffle_epi8(hi[c + 4], NARROW));
+        }
+}
+
+/********** reverse_ssse3_24 ********
+ *
+ * 3-byte run reversal four cells at a time: the 16 bytes that end at
+ * the last cell not yet moved are loaded (so never past the run), and
+ * their top four cells are shuffled into reverse order
+ ************************/
+__attribute__((target("ssse3")))
+static void reverse_ssse3_24(const void *src, void *dst, int n)
+{
+        const __m128i flip = _mm_setr_epi8(13, 14, 15, 10, 11, 12, 7, 8,
+                                           9, 4, 5, 6, -1, -1, -1, -1);
+        const char *s = src;
+        char *d = dst;
+        int k = 0;
+
+        for (; n - k >= 6; k += 4) {    /* 16 bytes lie inside the run */
+                __m128i x = _mm_loadu_si128((const __m128i *)
+                                            (s + 3 * (n - k) - 16));
+                store12(d + 3 * k, _mm_shuffle_epi8(x, flip));
+        }
+        for (; k < n; k++)
+                memcpy(d + 3 * k, s + 3 * (n - 1 - k), 3);
+}
+
+#endif
+
+/*
+ * Kernels for each cell size, best first.  The AVX2 kernels for 8- and
+ * 16-bit cells only widen the reversal; a 16x16 byte tile is already
+ * as large as the base case of the cache-oblivious recursion.
+ */
+static const Tile_kernel kernels8[] = {
+#ifdef TILE_X86
+        { "avx2",   16, transpose16_sse2_8, reverse_avx2_8   },
+        { "sse2",   16, transpose16_sse2_8, reverse_sse2_8   },
+#endif
+        { "scalar",  8, transpose8_scalar8, reverse_scalar8  },
+};
+
+static const Tile_kernel kernels16[] = {
+#ifdef TILE_X86
+        { "avx2",    8, transpose8_sse2_16, reverse_avx2_16  },
+        { "sse2",    8, transpose8_sse2_16, reverse_sse2_16  },
+#endif
+        { "scalar",  8, transpose8_scalar16, reverse_scalar16 },
+};
+
+static const Tile_kernel kernels24[] = {
+#ifdef TILE_X86
+        { "ssse3",  8, transpose8_ssse3_24, reverse_ssse3_24 },
+#endif
+        { "scalar", 8, transpose8_scalar24, reverse_scalar24 },
+};
+
+static const Tile_kernel kernels32[] = {
+#ifdef TILE_X86
+        { "avx2",   8, transpose8_avx2,   reverse_avx2   },
+        { "sse2",   4, transpose4_sse2,   reverse_sse2   },
+#endif
+        { "scalar", 4, transpose4_scalar32, reverse_scalar32 },
+};
+
+static const Tile_kernel kernels64[] = {
+#ifdef TILE_X86
+        { "avx2",   4, transpose4_avx2_64, reverse_avx2_64  },
+        { "sse2",   2, transpose2_sse2_64, reverse_sse2_64  },
+#endif
+        { "scalar", 4, transpose4_scalar64, reverse_scalar64 },
+};
+
+#define NELEMS(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+/********** table ********
+ *
+ * Sets '*k' and returns the number of kernels for cells of 'size'
+ * bytes; returns 0 if there are none
+ ************************/
+static int table(int size, const Tile_kernel **k)
+{
+        switch (size) {
+        case 1: *k = kernels8;  return NELEMS(kernels8);
+        case 2: *k = kernels16; return NELEMS(kernels16);
+        case 3: *k = kernels24; return NELEMS(kernels24);
+        case 4: *k = kernels32; return NELEMS(kernels32);
+        case 8: *k = kernels64; return NELEMS(kernels64);
+        }
+        return 0;
+}
+
+/********** supported ********
+ *
+ * Returns nonzero if this CPU can run 'k'
+ ************************/
+static int supported(const Tile_kernel *k)
+{
+#ifdef TILE_X86
+        if (strcmp(k->name, "avx2") == 0)
+                return __builtin_cpu_supports("avx2");
+        if (strcmp(k->name, "sse2") == 0)
+                return __builtin_cpu_supports("sse2");
+        if (strcmp(k->name, "ssse3") == 0)
+                return __builtin_cpu_supports("ssse3");
+#endif
+        return 1;
+}
+
+const Tile_kernel *Tile_kernel_named(int size, const char *name)
+{
+        const Tile_kernel *k = NULL;
+        int n = table(size, &k);
+
+        for (int i = 0; i < n; i++)
+                if (strcmp(k[i].name, name) == 0)
+                        return supported(&k[i]) ? &k[i] : NULL;
+        return NULL;
+}
+
+const Tile_kernel *Tile_kernel_for(int size)
+{
+        static const Tile_kernel *best[9];    /* by size */
+
+        if (size < 1 || size > 8)
+                return NULL;
+        if (best[size] == NULL) {
+                const Tile_kernel *k = NULL;
+                if (table(size, &k) == 0)
+                        return NULL;
+                while (!supported(k))           /* scalar always is */
+                        k++;
+                best[size] = k;
+        }
+        return best[size];
+}
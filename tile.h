@@ -0,0 +1,47 @@
+#ifndef TILE_INCLUDED
+#define TILE_INCLUDED
+
+/*
+ * In-register kernels for 8-, 16-, 24-, 32- and 64-bit cells (a sample
+ * of a planar image, or one packed RGB8, RGBX or RGBX16 pixel): square
+ * tile transposes, used as the base case of 90- and 270-degree
+ * rotation, and run reversal, used by horizontal flips.  The widest
+ * kernel the CPU supports is picked at run time: AVX2, SSE2 (SSSE3
+ * for 24-bit cells), or a scalar loop.  For 32-bit cells the tiles are
+ * 8x8, 4x4 and 4x4; for 16-bit cells 8x8; for bytes 16x16, or 8x8 in
+ * scalar; for 24-bit cells 8x8; for 64-bit cells 4x4, 2x2 and 4x4.
+ */
+
+#include <stddef.h>
+
+/*
+ * transposes one side by side tile: cell c of source row r (at
+ * src + r * src_stride bytes) becomes cell r of destination row c (at
+ * dst + c * dst_stride bytes); strides may be negative
+ */
+typedef void Tile_fun(const void *src, ptrdiff_t src_stride,
+                      void *dst, ptrdiff_t dst_stride);
+
+/* copies 'n' cells from 'src' to 'dst' in reverse order, so that
+ * dst[k] = src[n - 1 - k]; the runs must not overlap
+ */
+typedef void Tile_revfun(const void *src, void *dst, int n);
+
+typedef struct Tile_kernel {
+        const char  *name;      /* "avx2", "sse2", "ssse3", "scalar" */
+        int          side;      /* cells on each side of a tile */
+        Tile_fun    *transpose;
+        Tile_revfun *reverse;
+} Tile_kernel;
+
+/* the fastest kernel for this CPU and cells of 'size' bytes (1, 2, 3,
+ * 4 or 8), chosen on the first call; NULL for any other size
+ */
+extern const Tile_kernel *Tile_kernel_for(int size);
+
+/* the kernel for 'size'-byte cells called 'name', or NULL if there is
+ * none or this CPU cannot run it
+ */
+extern const Tile_kernel *Tile_kernel_named(int size, const char *name);
+
+#endif
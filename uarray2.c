@@ -1,71 +1,94 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "assert.h"
 #include "mem.h"
-#include "uarray.h"
 #include "uarray2.h"
 
 #define T UArray2_T
 
 /* 
  * Element (i, j) in the world of ideas maps to
- * rows[j][i] where the square brackets stand for access
- * to a Hanson UArray_T
+ * elems[j * stride + i * size] where elems is a single slab
+ * holding every row back to back.  Keeping the whole array in
+ * one allocation means no row headers to chase and no rows
+ * scattered across the heap.
  */
 struct T {
         int width, height;
         int size;
-        UArray_T rows; /* UArray_T of 'height' UArray_Ts,
-                          each of length 'width' and size 'size' */
+        size_t stride;  /* bytes from the start of row j to row j + 1 */
+        char *elems;    /* 'height' rows of 'stride' bytes,
+                           aligned to ALIGNMENT unless borrowed */
+        int borrowed;   /* elems belongs to the caller (UArray2_view) */
 };
 
-static inline UArray_T row(T a, int j)
+enum { ALIGNMENT = 64 };        /* one cache line on every target we run */
+
+static inline char *row(T a, int j)
 {
-        UArray_T *prow = UArray_at(a->rows, j);   /* Ramsey idiom */
-        return *prow;
+        return a->elems + (size_t)j * a->stride;
 }
 
 static int is_ok(T a)
 {
-        return a && UArray_length(a->rows) == a->height &&
-               UArray_size(a->rows) == sizeof(UArray_T) &&
-               (a->height == 0 || (UArray_length(row(a, 0)) == a->width
-                                   && UArray_size  (row(a, 0)) == a->size));
+        return a && a->width >= 0 && a->height >= 0 && a->size > 0 &&
+               a->stride == (size_t)a->width * a->size &&
+               a->elems != NULL &&
+               (a->borrowed || (size_t)a->elems % ALIGNMENT == 0);
 }
 
 T UArray2_new(int width, int height, int size)
 {
-        int i;  /* interates over row number */
         T array;
+        void *slab;
+        assert(width >= 0 && height >= 0 && size > 0);
         NEW(array);
         array->width  = width;
         array->height = height;
         array->size   = size;
-        array->rows   = UArray_new(height, sizeof(UArray_T));
-        for (i = 0; i < height; i++) {
-                UArray_T *rowp = UArray_at(array->rows, i);
-                *rowp = UArray_new(width, size);
-        }
+        array->stride = (size_t)width * size;
+
+        /* never ask for zero bytes, so elems is always a real pointer */
+        size_t nbytes = array->stride * height;
+        if (posix_memalign(&slab, ALIGNMENT, nbytes > 0 ? nbytes : 1) != 0)
+                slab = NULL;
+        assert(slab != NULL);
+        array->elems = slab;
+        array->borrowed = 0;
+        assert(is_ok(array));
+        return array;
+}
+
+T UArray2_view(int width, int height, int size, void *elems)
+{
+        T array;
+        assert(width >= 0 && height >= 0 && size > 0 && elems != NULL);
+        NEW(array);
+        array->width    = width;
+        array->height   = height;
+        array->size     = size;
+        array->stride   = (size_t)width * size;
+        array->elems    = elems;
+        array->borrowed = 1;
         assert(is_ok(array));
         return array;
 }
 
 void UArray2_free(T *array2)
 {
-        int i;
         assert(array2 != NULL && *array2 != NULL);
-        for (i = 0; i < (*array2)->height; i++) {
-                UArray_T p = row(*array2, i);
-                UArray_free(&p);
-        }
-        UArray_free(&(*array2)->rows);
+        if (!(*array2)->borrowed)
+                free((*array2)->elems);
         FREE(*array2);
 }
 
 void *UArray2_at(T array2, int i, int j)
 {
         assert(array2 != NULL);
-        return UArray_at(row(array2, j), i);
+        assert(i >= 0 && i < array2->width);
+        assert(j >= 0 && j < array2->height);
+        return row(array2, j) + (size_t)i * array2->size;
 }
 
 int UArray2_height(T array2)
@@ -94,11 +117,12 @@ void UArray2_map_row_major(T array2,
         assert(array2!= NULL);
         int h = array2->height;  /* keeping height and width in registers */
         int w = array2->width;   /* avoids extra memory traffic           */
+        int size = array2->size;
         for (int j = 0; j < h; j++) {
-                /* don't want row/UArray_at in inner loop */
-                UArray_T thisrow = row(array2, j); 
-                for (int i = 0; i < w; i++)
-                        apply(i, j, array2, UArray_at(thisrow, i), cl);
+                /* rows are contiguous, so just walk a pointer */
+                char *elem = row(array2, j); 
+                for (int i = 0; i < w; i++, elem += size)
+                        apply(i, j, array2, elem, cl);
         }
 }
 
@@ -110,7 +134,77 @@ void UArray2_map_col_major(T array2,
         assert(array2 != NULL);
         int h = array2->height;  /* keeping height and width in registers */
         int w = array2->width;   /* avoids extra memory traffic           */
-        for (int i = 0; i < w; i++)
-                for (int j = 0; j < h; j++)
-                        apply(i, j, array2, UArray_at(row(array2, j), i), cl);
-}
\ No newline at end of file
+        size_t stride = array2->stride;
+        for (int i = 0; i < w; i++) {
+                char *elem = array2->elems + (size_t)i * array2->size;
+                for (int j = 0; j < h; j++, elem += stride)
+                        apply(i, j, array2, elem, cl);
+        }
+}
+
+void UArray2_map_row_spans(T array2, UArray2_spanfun apply, void *cl)
+{
+        assert(array2 != NULL);
+        int h = array2->height;
+        for (int j = 0; j < h; j++)
+                apply(0, j, array2->width, row(array2, j), array2->size, cl);
+}
+
+/*
+ * Because rows are dense, the array is a plain width x height matrix
+ * of cells, and transposing it is a permutation of cell indices: the
+ * cell that ends up at index d (row d / height, column d % height of
+ * the result) comes from index (d % height) * width + d / height.
+ * Each cycle of the permutation is followed once, holding one cell
+ * aside; a bitmap records which indices are already done.
+ */
+void UArray2_transpose(T array2)
+{
+        assert(array2 != NULL);
+        const size_t w = array2->width, h = array2->height;
+        const size_t n = w * h;
+        const int size = array2->size;
+
+        if (w > 1 && h > 1) {
+                unsigned char *done = calloc((n + 7) / 8, 1);
+                char *held = malloc(size);
+                assert(done != NULL && held != NULL);
+
+                /* indices 0 and n - 1 never move */
+                for (size_t start = 1; start < n - 1; start++) {
+                        if (done[start / 8] & (1u << (start % 8)))
+                                continue;
+                        memcpy(held, array2->elems + start * size, size);
+                        size_t d = start;
+                        for (;;) {
+                                size_t s = (d % h) * w + d / h;
+                                done[d / 8] |= 1u << (d % 8);
+                                if (s == start)
+                                        break;
+                                memcpy(array2->elems + d * size,
+                                       array2->elems + s * size, size);
+                                d = s;
+                        }
+                        memcpy(array2->elems + d * size, held, size);
+                }
+                free(held);
+                free(done);
+        }
+
+        array2->width  = h;
+        array2->height = w;
+        array2->stride = h * size;
+        assert(is_ok(array2));
+}
+
+char *UArray2_base(T array2)
+{
+        assert(array2 != NULL);
+        return array2->elems;
+}
+
+size_t UArray2_stride(T array2)
+{
+        assert(array2 != NULL);
+        return array2->stride;
+}
@@ -0,0 +1,60 @@
+#ifndef UARRAY2_INCLUDED
+#define UARRAY2_INCLUDED
+
+#include <stddef.h>
+
+#define T UArray2_T
+typedef struct T *T;
+
+typedef void UArray2_applyfun(int i, int j, T array2, void *elem, void *cl);
+
+/* a span is 'length' consecutive cells of row j starting at column i;
+ * cell i + k is at (char *)first + k * stride
+ */
+typedef void UArray2_spanfun(int i, int j, int length, void *first,
+                             int stride, void *cl);
+
+extern T     UArray2_new   (int width, int height, int size);
+extern void  UArray2_free  (T *array2);
+
+/* an array over the caller's 'elems', rows back to back with no
+ * padding and no alignment required; UArray2_free leaves 'elems' alone
+ */
+extern T     UArray2_view  (int width, int height, int size, void *elems);
+
+/* return a pointer to the cell in column i, row j.
+ * index out of range is a checked run-time error
+ */
+extern void *UArray2_at    (T array2, int i, int j);
+
+extern int   UArray2_height(T array2);
+extern int   UArray2_width (T array2);
+extern int   UArray2_size  (T array2);
+
+extern void  UArray2_map_row_major(T array2, UArray2_applyfun apply,
+                                   void *cl);
+extern void  UArray2_map_col_major(T array2, UArray2_applyfun apply,
+                                   void *cl);
+
+/* calls 'apply' once per row, top to bottom, with the whole row */
+extern void  UArray2_map_row_spans(T array2, UArray2_spanfun apply,
+                                   void *cl);
+
+/* transposes in place: cell (i, j) moves to (j, i), and width and
+ * height trade places.  Extra memory is one bit per cell.
+ */
+extern void  UArray2_transpose(T array2);
+
+/* expose the storage so that traversals can be inlined (see
+ * a2inline.h): cell (i, j) is at base + j * stride + i * size
+ */
+extern char  *UArray2_base  (T array2);
+extern size_t UArray2_stride(T array2);
+
+/*
+ * it is a checked run-time error to pass a NULL T
+ * to any function in this interface 
+ */
+
+#undef T
+#endif
@@ -7,32 +7,72 @@
  *     Date:       October 7, 2024
  *
  *     Contains implementation of the uarray2b.c class,
- *     a 2D blocked array using the Hanson UArray class as an 
- *     underlying data structure. 
+ *     a 2D blocked array whose blocks all live in one contiguous,
+ *     aligned slab of memory.
  *
  ***************************************************************/
 
 #include "uarray2b.h"
-#include "uarray2.h"
+#include "cacheinfo.h"
 #include <math.h>
 #include <assert.h>
 #include <stdlib.h>
-#include <uarray.h>
 
 /* 
- * UArray2_T struct
- * Depicts a 2-dimensional unboxed array. 
+ * UArray2b_T struct
+ * Depicts a 2-dimensional blocked, unboxed array. 
  * Stores width and height of the array, the size of each element
- * and a Hanson `UArray_T` as a data structure
+ * and a single slab holding every block back to back, in row-major
+ * order of blocks.  Block (bcol, brow) starts at
+ * elems + (brow * col_blocks + bcol) * block_bytes, and element
+ * (i, j) within a block sits at offset (j * block_width + i) * size.
+ * Blocks are square unless created with UArray2b_new_rect.
  */
 struct UArray2b_T {
     int width; /* The width (num columns) of the array */
     int height; /* The height (num rows) of the array */
     int size; /* Size of data stored in each element of the array */
-    int blocksize; /* Size of each block for blocked array */
-    UArray2_T blocks; /* Hanson's UArray_T that holds data */
+    int block_width; /* Columns in each block */
+    int block_height; /* Rows in each block */
+    int log2_width; /* log2(block_width), or -1 if not a power of two */
+    int log2_height; /* log2(block_height), or -1 if not a power of two */
+    int col_blocks; /* Number of blocks across one row of blocks */
+    int row_blocks; /* Number of rows of blocks */
+    size_t block_bytes; /* Bytes per block, padded to a cache line */
+    char *elems; /* Page-aligned slab holding all blocks */
 };
 
+enum { CACHE_LINE = 64, PAGE = 4096 };
+
+/********** log2_exact ********
+ *
+ * Returns k if n == 2^k, and -1 if n is not a power of two
+ ************************/
+static int log2_exact(int n)
+{
+    int k = 0;
+    if (n <= 0 || (n & (n - 1)) != 0) {
+        return -1;
+    }
+    while ((1 << k) != n) {
+        k++;
+    }
+    return k;
+}
+
+/********** block_base ********
+ *
+ * Returns a pointer to the first element of block (bcol, brow)
+ *
+ * Notes:
+ *      - no bounds checking; callers have already validated indices
+ ************************/
+static inline char *block_base(UArray2b_T uarray2b, int bcol, int brow)
+{
+    size_t block = (size_t)brow * uarray2b->col_blocks + bcol;
+    return uarray2b->elems + block * uarray2b->block_bytes;
+}
+
 /********** UArray2b_new ********
  *
  * Allocates and returns a new blocked 2D array UArray2b_T containing 'width' 
@@ -53,16 +93,48 @@ struct UArray2b_T {
  * Notes:
  *      - Checked runtime error if width, size, height, or blocksize are 
  *        invalid values
- *      - Hanson's 'UArray2_T' is used to create a grid of blocks; each block
- *        is created as a 'UArray_T'
+ *      - a square case of 'UArray2b_new_rect'
  ************************/
 UArray2b_T UArray2b_new(int width, int height, int size, int blocksize)
+{
+        assert(blocksize > 0);
+        return UArray2b_new_rect(width, height, size, blocksize, blocksize);
+}
+
+/********** UArray2b_new_rect ********
+ *
+ * Allocates and returns a new blocked 2D array whose blocks are
+ * 'block_width' columns by 'block_height' rows
+ *
+ * Parameters:
+ *      int width:        the number of columns in the array
+ *      int height:       the number of rows in the array
+ *      int size:         the byte size of each element
+ *      int block_width:  number of columns in each block
+ *      int block_height: number of rows in each block
+ *
+ * Return: A new 'UArray2b_T' object illustrating the blocked 2D array
+ *
+ * Expects
+ *      all arguments must be greater than zero
+ * 
+ * Notes:
+ *      - Checked runtime error if any argument is invalid
+ *      - all blocks come from one page-aligned allocation; each block is
+ *        padded to a whole number of cache lines so every block starts
+ *        on a line boundary.  When block_width * size is itself a
+ *        multiple of the line size, every row of every block is
+ *        line-aligned too
+ ************************/
+UArray2b_T UArray2b_new_rect(int width, int height, int size,
+                             int block_width, int block_height)
 {
         /* ensure valid dimensions */
         assert(width > 0);
         assert(height > 0);
         assert(size > 0);
-        assert(blocksize > 0);
+        assert(block_width > 0);
+        assert(block_height > 0);
 
         /* allocate memory for UArray2b_T struct (2D blocked array) */
         UArray2b_T uarray2b = (UArray2b_T)malloc(sizeof(struct UArray2b_T));
@@ -71,22 +143,30 @@ UArray2b_T UArray2b_new(int width, int height, int size, int blocksize)
         uarray2b->width = width;
         uarray2b->height = height;
         uarray2b->size = size;
-        uarray2b->blocksize = blocksize; 
+        uarray2b->block_width = block_width; 
+        uarray2b->block_height = block_height; 
+        uarray2b->log2_width = log2_exact(block_width);
+        uarray2b->log2_height = log2_exact(block_height);
 
         /* calculate number of blocks required */
-        int col_block = (width + blocksize - 1) / blocksize;
-        int row_block = (height + blocksize - 1) / blocksize;
+        uarray2b->col_blocks = (width + block_width - 1) / block_width;
+        uarray2b->row_blocks = (height + block_height - 1) / block_height;
 
-        uarray2b->blocks = UArray2_new(col_block, row_block, sizeof(UArray_T));
+        size_t block_bytes = (size_t)block_width * block_height * size;
+        block_bytes = (block_bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+        uarray2b->block_bytes = block_bytes;
 
-        for (int row = 0; row < row_block; row++) {
-            for (int col = 0; col < col_block; col++) {
-                UArray_T block = UArray_new(blocksize * blocksize, size);
-                *(UArray_T *)UArray2_at(uarray2b->blocks, col, row) = block;
-            }
+        /* one allocation for every block */
+        void *slab = NULL;
+        size_t total = block_bytes * uarray2b->col_blocks
+                                   * uarray2b->row_blocks;
+        if (posix_memalign(&slab, PAGE, total) != 0) {
+            slab = NULL;
         }
+        assert(slab != NULL);
+        uarray2b->elems = slab;
 
-     return uarray2b;
+        return uarray2b;
 }
 
 /********** UArray2b_new_64K_block ********
@@ -127,9 +207,128 @@ UArray2b_T UArray2b_new_64K_block(int width, int height, int size)
     return UArray2b_new(width, height, size, blocksize_max);
 }
 
+/********** UArray2b_new_64K_pow2_block ********
+ *
+ * Same as 'UArray2b_new_64K_block', except the block edge is rounded down
+ * to a power of two so that indexing can use shifts and masks instead of
+ * division and modulus
+ *
+ * Parameters:
+ *      int width:     number of columns in the array
+ *      int height:    number of rows in the array
+ *      int size:      the byte size of each element
+ *
+ * Return: A new 'UArray2b_T' that represents the blocked 2D array
+ *
+ * Expects
+ *      width, height, and a valid size (greater than 0)
+ * 
+ * Notes:
+ *      - for 12-byte 'Pnm_rgb' pixels this gives 64 rather than 73
+ *      - a block always holds at least one element
+ ************************/
+UArray2b_T UArray2b_new_64K_pow2_block(int width, int height, int size) 
+{
+    assert(width > 0);
+    assert(height > 0);
+    assert(size > 0); 
+
+    int blocksize = 1;
+    while ((long)(2 * blocksize) * (2 * blocksize) * size <= 64 * 1024) {
+        blocksize *= 2;
+    }
+
+    return UArray2b_new(width, height, size, blocksize);
+}
+
+/********** UArray2b_new_cache_block ********
+ *
+ * Allocates and returns a 'UArray2b_T' whose blocks are sized for the
+ * caches of the machine we are running on, instead of a fixed 64KB
+ *
+ * Parameters:
+ *      int width:     number of columns in the array
+ *      int height:    number of rows in the array
+ *      int size:      the byte size of each element
+ *
+ * Return: A new 'UArray2b_T' that represents the blocked 2D array
+ *
+ * Expects
+ *      width, height, and a valid size (greater than 0)
+ * 
+ * Notes:
+ *      - 'Cache_block_bytes' leaves room for one source and one
+ *        destination block in the target cache level, so a rotation
+ *        from one blocked array to another keeps both blocks resident
+ *      - falls back to the 64KB budget when the caches are unknown
+ ************************/
+UArray2b_T UArray2b_new_cache_block(int width, int height, int size) 
+{
+    assert(width > 0);
+    assert(height > 0);
+    assert(size > 0); 
+
+    int blocksize = sqrt(Cache_block_bytes() / size);
+    if (blocksize < 1) {
+        blocksize = 1; 
+    }
+
+    return UArray2b_new(width, height, size, blocksize);
+}
+
+/********** UArray2b_new_64K_line_block ********
+ *
+ * Allocates and returns a 'UArray2b_T' with blocks of about 64KB whose
+ * rows are a whole number of cache lines
+ *
+ * Parameters:
+ *      int width:     number of columns in the array
+ *      int height:    number of rows in the array
+ *      int size:      the byte size of each element
+ *
+ * Return: A new 'UArray2b_T' that represents the blocked 2D array
+ *
+ * Expects
+ *      width, height, and a valid size (greater than 0)
+ * 
+ * Notes:
+ *      - the block width is the square 64KB edge rounded up to the
+ *        smallest pixel count that fills whole lines (16 pixels for 4-
+ *        and 12-byte elements); the height then takes what is left of
+ *        the 64KB
+ *      - no block row shares a cache line with another block
+ ************************/
+UArray2b_T UArray2b_new_64K_line_block(int width, int height, int size) 
+{
+    assert(width > 0);
+    assert(height > 0);
+    assert(size > 0); 
+
+    /* columns per whole number of lines: CACHE_LINE / gcd(size, line) */
+    int g = size, line = CACHE_LINE;
+    while (line != 0) {
+        int t = g % line;
+        g = line;
+        line = t;
+    }
+    int quantum = CACHE_LINE / g;
+
+    int edge = sqrt(64*1024 / size);
+    if (edge < 1) {
+        edge = 1; 
+    }
+    int block_width = (edge + quantum - 1) / quantum * quantum;
+    int block_height = 64*1024 / (block_width * size);
+    if (block_height < 1) {
+        block_height = 1; 
+    }
+
+    return UArray2b_new_rect(width, height, size, block_width, block_height);
+}
+
 /********** UArray2b_free ********
  *
- * All
+ * Frees the block slab and the 'UArray2b_T' struct itself
  *
  * Parameters:
  *      UArray2b_T *array2b: pointer to block array that needs to be freed. 
@@ -148,19 +347,8 @@ void UArray2b_free(UArray2b_T *array2b)
 {
     assert(array2b != NULL && *array2b != NULL);
 
-    int block_rows = UArray2_height((*array2b)->blocks);
-    int block_cols = UArray2_width((*array2b)->blocks);
-
-    /* free each block */
-    for (int row = 0; row < block_rows; row++) {
-        for (int col = 0; col < block_cols; col++) {
-            UArray_T *block = UArray2_at((*array2b)->blocks, col, row);
-            UArray_free(block);
-        }
-    }
-
-    /* free the block array */
-    UArray2_free(&(*array2b)->blocks);
+    /* a single slab holds every block */
+    free((*array2b)->elems);
     free(*array2b);
     *array2b = NULL;
 }
@@ -235,8 +423,8 @@ int UArray2b_size(UArray2b_T array2b)
 /********** UArray2b_blocksize ********
  *
  * Finds the block size of 'UArray2b_T.' Block size determines number of 
- * elements in a block. Each block is a square, meaning the dimensions are 
- * 'blocksize x blocksize'
+ * elements in a block. A square block has dimensions 
+ * 'blocksize x blocksize'; for a rectangular block this is its width
  *
  * Parameters:
  *      UArray2b_T array2b: blocked, 2D array whose blocksize we must find
@@ -254,7 +442,27 @@ int UArray2b_size(UArray2b_T array2b)
 int UArray2b_blocksize(UArray2b_T array2b)
 {
     assert(array2b != NULL);
-    return array2b->blocksize;
+    return array2b->block_width;
+}
+
+/********** UArray2b_block_width ********
+ *
+ * Returns the number of columns in each block of 'array2b'
+ ************************/
+int UArray2b_block_width(UArray2b_T array2b)
+{
+    assert(array2b != NULL);
+    return array2b->block_width;
+}
+
+/********** UArray2b_block_height ********
+ *
+ * Returns the number of rows in each block of 'array2b'
+ ************************/
+int UArray2b_block_height(UArray2b_T array2b)
+{
+    assert(array2b != NULL);
+    return array2b->block_height;
 }
 
 /********** UArray2b_at ********
@@ -287,16 +495,162 @@ void *UArray2b_at(UArray2b_T uarray2b, int col, int row)
     assert(col >= 0 && col < uarray2b->width);
     assert(row >= 0 && row < uarray2b->height);
 
-    int block_col = col / uarray2b->blocksize;
-    int block_row = row / uarray2b->blocksize;
+    if (uarray2b->log2_width >= 0 && uarray2b->log2_height >= 0) {
+        return UArray2b_at_pow2(uarray2b, col, row);
+    }
+
+    int block_col = col / uarray2b->block_width;
+    int block_row = row / uarray2b->block_height;
     
-    int i_block_col = col % uarray2b->blocksize;
-    int i_block_row = row % uarray2b->blocksize;
+    int i_block_col = col % uarray2b->block_width;
+    int i_block_row = row % uarray2b->block_height;
     
-    UArray_T *block = UArray2_at(uarray2b->blocks, block_col, block_row);
-    int index = i_block_row * uarray2b->blocksize + i_block_col;
+    char *block = block_base(uarray2b, block_col, block_row);
+    int index = i_block_row * uarray2b->block_width + i_block_col;
+
+    return block + (size_t)index * uarray2b->size;
+}
+
+/********** UArray2b_at_pow2 ********
+ *
+ * Returns pointer to element at specific column and row in a 'UArray2b_T'
+ * whose block dimensions are powers of two, using shifts and masks in place of
+ * division and modulus
+ *
+ * Parameters:
+ *      UArray2b_T uarray2b: blocked 2D array where an element can be accessed
+ *      int col:             column index of element to access
+ *      int row:             row index of the element to access
+ *
+ * Return: void pointer to element at (col, row) position in the blocked array
+ *
+ * Expects
+ *      - 'uarray2b' must be a valid, non-NULL input whose block width
+ *        and height are powers of two
+ *      - col and row are within bounds of the array
+ * 
+ * Notes:
+ *      - checked runtime error if any expectation is violated
+ *      
+ ************************/
+void *UArray2b_at_pow2(UArray2b_T uarray2b, int col, int row)
+{
+    assert(uarray2b != NULL);
+    assert(uarray2b->log2_width >= 0 && uarray2b->log2_height >= 0);
+    assert(col >= 0 && col < uarray2b->width);
+    assert(row >= 0 && row < uarray2b->height);
+
+    int lw = uarray2b->log2_width;
+    int lh = uarray2b->log2_height;
+
+    char *block = block_base(uarray2b, col >> lw, row >> lh);
+    int index = ((row & (uarray2b->block_height - 1)) << lw)
+                | (col & (uarray2b->block_width - 1));
+
+    return block + (size_t)index * uarray2b->size;
+}
+
+typedef void Apply_fn(int col, int row, UArray2b_T uarray2b, void *elem,
+                      void *cl);
+
+/********** map_full_block ********
+ *
+ * Applies 'apply' to every cell of a block that lies entirely inside the
+ * array; the trip counts are the block dimensions, with no clipping
+ *
+ * Notes:
+ *      - 'elem' walks the block's cells, which are contiguous, in order
+ *      - the call through 'apply' stays indirect, so neither this loop
+ *        nor the fixed-size ones below can be vectorized; clients that
+ *        want that inline their kernel with a2inline.h instead
+ ************************/
+static void map_full_block(UArray2b_T uarray2b, int col0, int row0,
+                           char *elem, Apply_fn apply, void *cl)
+{
+    int block_width = uarray2b->block_width;
+    int block_height = uarray2b->block_height;
+    int size = uarray2b->size;
+
+    for (int row = row0; row < row0 + block_height; row++) {
+        for (int col = col0; col < col0 + block_width; col++, elem += size) {
+            apply(col, row, uarray2b, elem, cl);
+        }
+    }
+}
 
-    return UArray_at(*block, index);
+/*
+ * map_full_block for square blocks of SIDE x SIDE cells: both trip
+ * counts are constants, so the compiler can unroll the row loop and
+ * drop the loop bookkeeping around each call
+ */
+#define MAP_FULL_BLOCK_SQUARE(SIDE)                                     \
+static void map_full_block_##SIDE(UArray2b_T uarray2b, int col0,        \
+                                  int row0, char *elem, Apply_fn apply, \
+                                  void *cl)                             \
+{                                                                       \
+    int size = uarray2b->size;                                          \
+                                                                        \
+    for (int i = 0; i < SIDE; i++) {                                    \
+        for (int j = 0; j < SIDE; j++, elem += size) {                  \
+            apply(col0 + j, row0 + i, uarray2b, elem, cl);              \
+        }                                                               \
+    }                                                                   \
+}
+
+MAP_FULL_BLOCK_SQUARE(8)
+MAP_FULL_BLOCK_SQUARE(16)
+MAP_FULL_BLOCK_SQUARE(32)
+MAP_FULL_BLOCK_SQUARE(64)
+MAP_FULL_BLOCK_SQUARE(128)
+
+typedef void Full_block_fn(UArray2b_T uarray2b, int col0, int row0,
+                           char *elem, Apply_fn apply, void *cl);
+
+/********** full_block_fn ********
+ *
+ * Returns the interior-block loop for the shape of 'uarray2b's blocks:
+ * a fixed-size one for square blocks of 8 to 128 cells a side (the
+ * power-of-two sizes the 64KB constructors give), the general one
+ * otherwise
+ ************************/
+static Full_block_fn *full_block_fn(UArray2b_T uarray2b)
+{
+    if (uarray2b->block_width != uarray2b->block_height) {
+        return map_full_block;
+    }
+    switch (uarray2b->block_width) {
+    case 8:   return map_full_block_8;
+    case 16:  return map_full_block_16;
+    case 32:  return map_full_block_32;
+    case 64:  return map_full_block_64;
+    case 128: return map_full_block_128;
+    }
+    return map_full_block;
+}
+
+/********** map_edge_block ********
+ *
+ * Applies 'apply' to the cells of a block on the right or bottom edge
+ * that lie inside the array ('width' columns by 'height' rows)
+ *
+ * Notes:
+ *      - skips the unused tail of each block row
+ ************************/
+static void map_edge_block(UArray2b_T uarray2b, int col0, int row0,
+                           int width, int height, char *block,
+                           void apply(int col, int row, UArray2b_T uarray2b, 
+                                      void *elem, void *cl),
+                           void *cl)
+{
+    int size = uarray2b->size;
+    size_t stride = (size_t)uarray2b->block_width * size;
+
+    for (int i = 0; i < height; i++) {
+        char *elem = block + i * stride;
+        for (int j = 0; j < width; j++, elem += size) {
+            apply(col0 + j, row0 + i, uarray2b, elem, cl);
+        }
+    }
 }
 
 /********** UArray2b_map ********
@@ -323,7 +677,15 @@ void *UArray2b_at(UArray2b_T uarray2b, int col, int row)
  *      'apply' must be a non-NULL function pointer 
  * 
  * Notes:
- *      - none
+ *      - blocks that lie wholly inside the array (nearly all of them in a
+ *        large image) go through 'map_full_block', or a copy of it with
+ *        constant trip counts for square blocks of 8 to 128 cells, with
+ *        no clipping; only the last block column and the last block row
+ *        can be partial and take 'map_edge_block'
+ *      - 'apply' is called through a pointer for every cell, which
+ *        rules out vectorizing any of these loops
+ *      - cells are reached by a running pointer, so no element needs a
+ *        division, modulus, or multiply, whatever the block shape
  *      
  ************************/
 void UArray2b_map(UArray2b_T uarray2b,
@@ -332,31 +694,168 @@ void UArray2b_map(UArray2b_T uarray2b,
 {
     assert(uarray2b != NULL && apply != NULL);
 
-    int row_block = UArray2_height(uarray2b->blocks);
-    int col_block = UArray2_width(uarray2b->blocks);
+    int block_width = uarray2b->block_width;
+    int block_height = uarray2b->block_height;
+    int full_rows = uarray2b->height / block_height;
+    int full_cols = uarray2b->width / block_width;
+    int edge_width = uarray2b->width - full_cols * block_width;
+    int edge_height = uarray2b->height - full_rows * block_height;
 
-    for (int row = 0; row < row_block; row++) {
-        for (int col = 0; col < col_block; col++) {
-            UArray_T *block = UArray2_at(uarray2b->blocks, col, row);
-            int height = uarray2b->blocksize;
-            int width =  uarray2b->blocksize;
+    Full_block_fn *full_block = full_block_fn(uarray2b);
 
-            if ((row + 1) * uarray2b->blocksize > uarray2b->height) {
-                height = uarray2b->height - row * uarray2b->blocksize;
-            } 
-            if ((col + 1) * uarray2b->blocksize > uarray2b->width) {
-                width = uarray2b->width - col * uarray2b->blocksize;
+    /* blocks are laid out in the order visited, so this streams the slab */
+    for (int row = 0; row < full_rows; row++) {
+        int row0 = row * block_height;
+        for (int col = 0; col < full_cols; col++) {
+            full_block(uarray2b, col * block_width, row0,
+                       block_base(uarray2b, col, row), apply, cl);
+        }
+        if (edge_width > 0) {
+            map_edge_block(uarray2b, full_cols * block_width, row0,
+                           edge_width, block_height,
+                           block_base(uarray2b, full_cols, row), apply, cl);
+        }
+    }
+
+    /* bottom row of blocks, all clipped vertically */
+    if (edge_height > 0) {
+        int row0 = full_rows * block_height;
+        for (int col = 0; col < uarray2b->col_blocks; col++) {
+            int width = col < full_cols ? block_width : edge_width;
+            map_edge_block(uarray2b, col * block_width, row0, width,
+                           edge_height, block_base(uarray2b, col, full_rows),
+                           apply, cl);
+        }
+    }
+}
+
+/********** UArray2b_map_blocks ********
+ *
+ * Calls 'apply' once per block of 'uarray2b', in block-major order, so
+ * clients can run their own tight loop over each block instead of
+ * taking one call per element
+ *
+ * Parameters:
+ *      UArray2b_T uarray2b: blocked, 2D array whose blocks will be visited
+ *      void apply(...):     function provided by user, called with
+ *              - 'col' and 'row': position of the block's upper-left cell
+ *              - 'width' and 'height': columns and rows of the block that
+ *                lie inside the array (smaller at the right/bottom edges)
+ *              - 'base': pointer to the block's upper-left cell
+ *              - 'stride': bytes from one row of the block to the next
+ *              - 'cl': closure pointer passed through unchanged
+ *      void *cl:            closure pointer for any data 'apply' may need
+ *
+ * Return: none
+ *
+ * Expects
+ *      'uarray2b' must be a valid, non-NULL input
+ *      'apply' must be a non-NULL function pointer 
+ * 
+ * Notes:
+ *      - element (c, r) of a block is at base + r * stride + c * size
+ *      
+ ************************/
+void UArray2b_map_blocks(UArray2b_T uarray2b,
+                         void apply(int col, int row, int width, int height,
+                                    void *base, int stride, void *cl),
+                         void *cl)
+{
+    assert(uarray2b != NULL && apply != NULL);
+
+    int block_width = uarray2b->block_width;
+    int block_height = uarray2b->block_height;
+    int stride = block_width * uarray2b->size;
+
+    for (int row = 0; row < uarray2b->row_blocks; row++) {
+        int row0 = row * block_height;
+        int height = uarray2b->height - row0;
+        if (height > block_height) {
+            height = block_height;
+        }
+        for (int col = 0; col < uarray2b->col_blocks; col++) {
+            int col0 = col * block_width;
+            int width = uarray2b->width - col0;
+            if (width > block_width) {
+                width = block_width;
             }
+            apply(col0, row0, width, height, block_base(uarray2b, col, row),
+                  stride, cl);
+        }
+    }
+}
 
-            for (int i = 0; i < height; i++) {
-                for (int j = 0; j < width; j++) {
-                    int col2 = col * uarray2b->blocksize + j;
-                    int row2 = row * uarray2b->blocksize + i;
-                    int index = i * uarray2b->blocksize + j;
-                    void *elem = UArray_at(*block, index);
-                    apply(col2, row2, uarray2b, elem, cl);
-                }
+/********** UArray2b_map_spans ********
+ *
+ * Calls 'apply' once per row of every block, in block-major order, with
+ * the contiguous run of cells in that block row
+ *
+ * Parameters:
+ *      UArray2b_T uarray2b: blocked, 2D array whose cells will be visited
+ *      void apply(...):     function provided by user, called with
+ *              - 'col' and 'row': position of the run's first cell
+ *              - 'length': number of cells in the run (the block width,
+ *                or less in the last block column)
+ *              - 'first': pointer to the run's first cell
+ *              - 'stride': bytes from one cell of the run to the next
+ *              - 'cl': closure pointer passed through unchanged
+ *      void *cl:            closure pointer for any data 'apply' may need
+ *
+ * Return: none
+ *
+ * Expects
+ *      'uarray2b' must be a valid, non-NULL input
+ *      'apply' must be a non-NULL function pointer 
+ ************************/
+void UArray2b_map_spans(UArray2b_T uarray2b,
+                        void apply(int col, int row, int length,
+                                   void *first, int stride, void *cl),
+                        void *cl)
+{
+    assert(uarray2b != NULL && apply != NULL);
+
+    int block_width = uarray2b->block_width;
+    int block_height = uarray2b->block_height;
+    int size = uarray2b->size;
+    size_t row_bytes = (size_t)block_width * size;
+
+    for (int row = 0; row < uarray2b->row_blocks; row++) {
+        int row0 = row * block_height;
+        int height = uarray2b->height - row0;
+        if (height > block_height) {
+            height = block_height;
+        }
+        for (int col = 0; col < uarray2b->col_blocks; col++) {
+            int col0 = col * block_width;
+            int width = uarray2b->width - col0;
+            if (width > block_width) {
+                width = block_width;
+            }
+            char *first = block_base(uarray2b, col, row);
+            for (int i = 0; i < height; i++, first += row_bytes) {
+                apply(col0, row0 + i, width, first, size, cl);
             }
         }
     }
-}        
\ No newline at end of file
+}
+
+/********** UArray2b_base ********
+ *
+ * Returns a pointer to the first cell of the first block, so that
+ * traversals generated in a2inline.h can walk the slab directly
+ ************************/
+char *UArray2b_base(UArray2b_T uarray2b)
+{
+    assert(uarray2b != NULL);
+    return uarray2b->elems;
+}
+
+/********** UArray2b_block_bytes ********
+ *
+ * Returns the distance in bytes from the start of one block to the next
+ ************************/
+size_t UArray2b_block_bytes(UArray2b_T uarray2b)
+{
+    assert(uarray2b != NULL);
+    return uarray2b->block_bytes;
+}
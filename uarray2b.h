@@ -0,0 +1,108 @@
+#ifndef UARRAY2B_INCLUDED
+#define UARRAY2B_INCLUDED
+
+#include <stddef.h>
+
+#define T UArray2b_T
+typedef struct T *T;
+
+/* new blocked 2d array
+ * blocksize = square root of # of cells in block.
+ * blocksize < 1 is a checked runtime error
+ * a blocksize that is a power of two gets shift-and-mask indexing
+ */
+extern T    UArray2b_new (int width, int height, int size, int blocksize);
+
+/* new blocked 2d array with rectangular blocks of block_width columns
+ * by block_height rows; either < 1 is a checked runtime error.
+ * Choosing block_width * size as a multiple of 64 makes every block
+ * row start on a cache line
+ */
+extern T    UArray2b_new_rect(int width, int height, int size,
+                              int block_width, int block_height);
+
+/* new blocked 2d array: blocksize as large as possible provided
+ * block occupies at most 64KB (if possible)
+ */
+extern T    UArray2b_new_64K_block(int width, int height, int size);
+
+/* new blocked 2d array: blocksize is the largest power of two
+ * such that a block occupies at most 64KB (if possible)
+ */
+extern T    UArray2b_new_64K_pow2_block(int width, int height, int size);
+
+/* new blocked 2d array: blocksize as large as possible provided a
+ * source block and a destination block fit in the per-core cache
+ * level chosen by Cache_target_level() (see cacheinfo.h)
+ */
+extern T    UArray2b_new_cache_block(int width, int height, int size);
+
+/* new blocked 2d array: blocks of at most 64KB (if possible) whose
+ * rows are a whole number of 64-byte cache lines
+ */
+extern T    UArray2b_new_64K_line_block(int width, int height, int size);
+
+extern void  UArray2b_free     (T *array2b);
+
+extern int   UArray2b_width    (T  array2b);
+extern int   UArray2b_height   (T  array2b);
+extern int   UArray2b_size     (T  array2b);
+extern int   UArray2b_blocksize(T  array2b);   /* block width if not square */
+extern int   UArray2b_block_width (T array2b);
+extern int   UArray2b_block_height(T array2b);
+
+/* return a pointer to the cell in the given column and row.
+ * index out of range is a checked run-time error
+ */
+extern void *UArray2b_at(T array2b, int column, int row);
+
+/* same as UArray2b_at, but only for arrays whose block width and
+ * height are powers of two (checked run-time error otherwise); no
+ * division
+ */
+extern void *UArray2b_at_pow2(T array2b, int column, int row);
+
+/* visits every cell in one block before moving to another block */
+extern void  UArray2b_map(T array2b, 
+                          void apply(int col, int row, T array2b,
+                                     void *elem, void *cl),
+                          void *cl);
+
+/* visits every block once, in the same order as UArray2b_map, passing
+ * the (col, row) of the block's upper-left cell, the number of columns
+ * and rows of the block that lie inside the array, a pointer to the
+ * upper-left cell, and the byte distance between rows of the block
+ */
+extern void  UArray2b_map_blocks(T array2b,
+                                 void apply(int col, int row,
+                                            int width, int height,
+                                            void *base, int stride,
+                                            void *cl),
+                                 void *cl);
+
+/* visits every row of every block once, in the same order as
+ * UArray2b_map: 'apply' gets the (col, row) of the first cell, the
+ * number of cells in the run, a pointer to the first cell, and the byte
+ * distance between cells of the run
+ */
+extern void  UArray2b_map_spans(T array2b,
+                                void apply(int col, int row, int length,
+                                           void *first, int stride,
+                                           void *cl),
+                                void *cl);
+
+/* expose the storage so that traversals can be inlined (see
+ * a2inline.h): blocks are stored in row-major order of blocks, each
+ * 'block_bytes' long starting at base; cells within a block are
+ * row-major with block_width cells per row
+ */
+extern char  *UArray2b_base       (T array2b);
+extern size_t UArray2b_block_bytes(T array2b);
+
+/*
+ * it is a checked run-time error to pass a NULL T
+ * to any function in this interface 
+ */
+
+#undef T
+#endif
@@ -0,0 +1,443 @@
+/**************************************************************
+ *
+ *                     uarray2h.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall 
+ *     Date:       October 7, 2024
+ *
+ *     Contains implementation of the uarray2h.c class, a 2D array
+ *     blocked at two levels: 64KB-class blocks made of small tiles
+ *     sized for the L1 cache.  A 90-degree rotation writes the
+ *     destination column-wise; with one level of blocking that walks
+ *     a whole 64KB block, but here it stays inside one L1-sized tile.
+ *
+ ***************************************************************/
+
+#include "uarray2h.h"
+#include "cacheinfo.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/* 
+ * UArray2h_T struct
+ * Blocks are stored in row-major order of blocks; within a block, tiles
+ * are stored in row-major order of tiles; within a tile, cells are
+ * stored row-major.  Every block is allocated in full, so the tile grid
+ * of a block is the same everywhere and all indexing is shifts and
+ * masks.
+ */
+struct UArray2h_T {
+    int width; /* The width (num columns) of the array */
+    int height; /* The height (num rows) of the array */
+    int size; /* Size of data stored in each element of the array */
+    int block_log; /* log2 of the cells per side of a block */
+    int tile_log; /* log2 of the cells per side of a tile */
+    int col_blocks; /* Number of blocks across one row of blocks */
+    int row_blocks; /* Number of rows of blocks */
+    char *elems; /* Page-aligned slab holding all blocks */
+};
+
+enum { PAGE = 4096, OUTER_BYTES = 64 * 1024, FALLBACK_L1 = 32 * 1024 };
+
+/********** log2_exact ********
+ *
+ * Returns k if n == 2^k, and -1 if n is not a power of two
+ ************************/
+static int log2_exact(int n)
+{
+    int k = 0;
+    if (n <= 0 || (n & (n - 1)) != 0) {
+        return -1;
+    }
+    while ((1 << k) != n) {
+        k++;
+    }
+    return k;
+}
+
+/********** pow2_edge ********
+ *
+ * Returns the largest power of two e such that e * e cells of 'size'
+ * bytes fit in 'budget' bytes (at least 1)
+ ************************/
+static int pow2_edge(long budget, int size)
+{
+    int edge = 1;
+    while ((long)(2 * edge) * (2 * edge) * size <= budget) {
+        edge *= 2;
+    }
+    return edge;
+}
+
+/********** tile_base ********
+ *
+ * Returns a pointer to the first cell of the tile holding (col, row)
+ *
+ * Notes:
+ *      - no bounds checking; callers have already validated indices
+ ************************/
+static inline char *tile_base(UArray2h_T a, int col, int row)
+{
+    int lb = a->block_log, lt = a->tile_log;
+    int tiles_log = lb - lt;        /* log2 of tiles per side of a block */
+    int tmask = (1 << tiles_log) - 1;
+
+    size_t block = (size_t)(row >> lb) * a->col_blocks + (col >> lb);
+    size_t tile = ((size_t)((row >> lt) & tmask) << tiles_log)
+                  | ((col >> lt) & tmask);
+    size_t index = (block << (2 * lb)) | (tile << (2 * lt));
+    return a->elems + index * a->size;
+}
+
+/********** UArray2h_new ********
+ *
+ * Allocates and returns a new two-level blocked 2D array
+ *
+ * Parameters:
+ *      int width:     the number of columns in the array
+ *      int height:    the number of rows in the array
+ *      int size:      the byte size of each element
+ *      int blocksize: cells per side of an outer block (power of two)
+ *      int tilesize:  cells per side of an inner tile (power of two,
+ *                     no larger than blocksize)
+ *
+ * Return: A new 'UArray2h_T'
+ *
+ * Expects
+ *      all arguments positive, and the sizes as described above
+ * 
+ * Notes:
+ *      - Checked runtime error if any expectation is violated
+ ************************/
+UArray2h_T UArray2h_new(int width, int height, int size, int blocksize,
+                        int tilesize)
+{
+    assert(width > 0);
+    assert(height > 0);
+    assert(size > 0);
+    int block_log = log2_exact(blocksize);
+    int tile_log = log2_exact(tilesize);
+    assert(block_log >= 0 && tile_log >= 0 && tile_log <= block_log);
+
+    UArray2h_T uarray2h = malloc(sizeof(struct UArray2h_T));
+    assert(uarray2h != NULL);
+
+    uarray2h->width = width;
+    uarray2h->height = height;
+    uarray2h->size = size;
+    uarray2h->block_log = block_log;
+    uarray2h->tile_log = tile_log;
+    uarray2h->col_blocks = (width + blocksize - 1) / blocksize;
+    uarray2h->row_blocks = (height + blocksize - 1) / blocksize;
+
+    void *slab = NULL;
+    size_t total = (size_t)uarray2h->col_blocks * uarray2h->row_blocks
+                   * blocksize * blocksize * size;
+    if (posix_memalign(&slab, PAGE, total) != 0) {
+        slab = NULL;
+    }
+    assert(slab != NULL);
+    uarray2h->elems = slab;
+
+    return uarray2h;
+}
+
+/********** UArray2h_new_default ********
+ *
+ * Allocates and returns a two-level blocked 2D array with 64KB-class
+ * blocks made of L1-sized tiles
+ *
+ * Parameters:
+ *      int width:     number of columns in the array
+ *      int height:    number of rows in the array
+ *      int size:      the byte size of each element
+ *
+ * Return: A new 'UArray2h_T'
+ *
+ * Expects
+ *      width, height, and size greater than 0
+ * 
+ * Notes:
+ *      - a tile may use a quarter of L1, so a source tile and a
+ *        destination tile together take half of it
+ *      - assumes a 32KB L1 if the cache size cannot be found
+ ************************/
+UArray2h_T UArray2h_new_default(int width, int height, int size)
+{
+    assert(size > 0);
+    int blocksize = pow2_edge(OUTER_BYTES, size);
+    int tilesize = UArray2h_default_tilesize(size);
+    if (tilesize > blocksize) {
+        tilesize = blocksize;
+    }
+    return UArray2h_new(width, height, size, blocksize, tilesize);
+}
+
+/********** UArray2h_default_tilesize ********
+ *
+ * Returns the largest power-of-two tile edge for cells of 'size' bytes
+ * such that a tile takes at most a quarter of the L1 data cache
+ ************************/
+int UArray2h_default_tilesize(int size)
+{
+    assert(size > 0);
+    long l1 = Cache_size(1);
+    if (l1 <= 0) {
+        l1 = FALLBACK_L1;
+    }
+    return pow2_edge(l1 / 4, size);
+}
+
+/********** UArray2h_free ********
+ *
+ * Frees the slab and the 'UArray2h_T' struct itself; sets *array2h to
+ * NULL
+ ************************/
+void UArray2h_free(UArray2h_T *array2h)
+{
+    assert(array2h != NULL && *array2h != NULL);
+    free((*array2h)->elems);
+    free(*array2h);
+    *array2h = NULL;
+}
+
+/********** UArray2h_width ********
+ *
+ * Returns width, or number of columns, of 'array2h'
+ ************************/
+int UArray2h_width(UArray2h_T array2h)
+{
+    assert(array2h != NULL);
+    return array2h->width;
+}
+
+/********** UArray2h_height ********
+ *
+ * Returns height, or number of rows, of 'array2h'
+ ************************/
+int UArray2h_height(UArray2h_T array2h)
+{
+    assert(array2h != NULL);
+    return array2h->height;
+}
+
+/********** UArray2h_size ********
+ *
+ * Returns size (in bytes) of each element of 'array2h'
+ ************************/
+int UArray2h_size(UArray2h_T array2h)
+{
+    assert(array2h != NULL);
+    return array2h->size;
+}
+
+/********** UArray2h_blocksize ********
+ *
+ * Returns the number of cells per side of an outer block
+ ************************/
+int UArray2h_blocksize(UArray2h_T array2h)
+{
+    assert(array2h != NULL);
+    return 1 << array2h->block_log;
+}
+
+/********** UArray2h_tilesize ********
+ *
+ * Returns the number of cells per side of an inner tile
+ ************************/
+int UArray2h_tilesize(UArray2h_T array2h)
+{
+    assert(array2h != NULL);
+    return 1 << array2h->tile_log;
+}
+
+/********** UArray2h_at ********
+ *
+ * Returns pointer to element at specific column and row of 'uarray2h'
+ *
+ * Parameters:
+ *      UArray2h_T uarray2h: array where an element is accessed
+ *      int col:             column index of element (0 <= col < width)
+ *      int row:             row index of element (0 <= row < height)
+ *
+ * Return: void pointer to element at (col, row)
+ *
+ * Expects
+ *      - 'uarray2h' must be a valid, non-NULL input
+ *      - col and row are within bounds of the array
+ * 
+ * Notes:
+ *      - checked runtime error if any expectation is violated
+ ************************/
+void *UArray2h_at(UArray2h_T uarray2h, int col, int row)
+{
+    assert(uarray2h != NULL);
+    assert(col >= 0 && col < uarray2h->width);
+    assert(row >= 0 && row < uarray2h->height);
+
+    int mask = (1 << uarray2h->tile_log) - 1;
+    int index = ((row & mask) << uarray2h->tile_log) | (col & mask);
+    return tile_base(uarray2h, col, row) + (size_t)index * uarray2h->size;
+}
+
+/********** UArray2h_map_tiles ********
+ *
+ * Calls 'apply' once per tile that holds at least one cell of the array,
+ * in storage order: block by block, and tile by tile within a block
+ *
+ * Parameters:
+ *      UArray2h_T uarray2h: array whose tiles will be visited
+ *      void apply(...):     called with the tile's upper-left (col, row),
+ *                           the columns and rows of it inside the array,
+ *                           a pointer to its first cell, the byte stride
+ *                           between its rows, and 'cl'
+ *      void *cl:            closure pointer for any data 'apply' may need
+ *
+ * Expects
+ *      'uarray2h' must be a valid, non-NULL input
+ *      'apply' must be a non-NULL function pointer 
+ ************************/
+void UArray2h_map_tiles(UArray2h_T uarray2h,
+                        void apply(int col, int row, int width, int height,
+                                   void *base, int stride, void *cl),
+                        void *cl)
+{
+    assert(uarray2h != NULL && apply != NULL);
+
+    int blocksize = 1 << uarray2h->block_log;
+    int tilesize = 1 << uarray2h->tile_log;
+    int stride = tilesize * uarray2h->size;
+
+    for (int brow = 0; brow < uarray2h->row_blocks; brow++) {
+        for (int bcol = 0; bcol < uarray2h->col_blocks; bcol++) {
+            int col0 = bcol * blocksize, row0 = brow * blocksize;
+            for (int trow = row0; trow < row0 + blocksize &&
+                                  trow < uarray2h->height; trow += tilesize) {
+                int height = uarray2h->height - trow;
+                if (height > tilesize) {
+                    height = tilesize;
+                }
+                for (int tcol = col0; tcol < col0 + blocksize &&
+                                      tcol < uarray2h->width;
+                     tcol += tilesize) {
+                    int width = uarray2h->width - tcol;
+                    if (width > tilesize) {
+                        width = tilesize;
+                    }
+                    apply(tcol, trow, width, height,
+                          tile_base(uarray2h, tcol, trow), stride, cl);
+                }
+            }
+        }
+    }
+}
+
+struct map_closure {
+    UArray2h_T uarray2h;
+    void (*apply)(int col, int row, UArray2h_T uarray2h, void *elem,
+                  void *cl);
+    void *cl;
+};
+
+/********** map_tile ********
+ *
+ * Applies the client's function to every cell of one tile; full tiles
+ * take a loop with a fixed trip count
+ ************************/
+static void map_tile(int col, int row, int width, int height, void *base,
+                     int stride, void *vcl)
+{
+    struct map_closure *mcl = vcl;
+    UArray2h_T uarray2h = mcl->uarray2h;
+    int size = uarray2h->size;
+    int tilesize = 1 << uarray2h->tile_log;
+    char *elem = base;
+
+    if (width == tilesize && height == tilesize) {
+        for (int r = row; r < row + tilesize; r++) {
+            for (int c = col; c < col + tilesize; c++, elem += size) {
+                mcl->apply(c, r, uarray2h, elem, mcl->cl);
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < height; i++) {
+        elem = (char *)base + (size_t)i * stride;
+        for (int j = 0; j < width; j++, elem += size) {
+            mcl->apply(col + j, row + i, uarray2h, elem, mcl->cl);
+        }
+    }
+}
+
+/********** UArray2h_map ********
+ *
+ * Iterates through each element of 'uarray2h' in storage order (tile by
+ * tile within each block, block by block) and applies 'apply' to it
+ *
+ * Parameters:
+ *      UArray2h_T uarray2h: array whose elements are visited
+ *      void apply(...):     function applied to every element, given the
+ *                           element's col and row, the array, a pointer
+ *                           to the element, and 'cl'
+ *      void *cl:            closure pointer passed through to 'apply'
+ *
+ * Expects
+ *      'uarray2h' must be a valid, non-NULL input
+ *      'apply' must be a non-NULL function pointer 
+ ************************/
+void UArray2h_map(UArray2h_T uarray2h,
+                  void apply(int col, int row, UArray2h_T uarray2h, 
+                  void *elem, void *cl), void *cl)
+{
+    assert(uarray2h != NULL && apply != NULL);
+    struct map_closure mcl = { uarray2h, apply, cl };
+    UArray2h_map_tiles(uarray2h, map_tile, &mcl);
+}
+
+struct span_closure {
+    int size;
+    void (*apply)(int col, int row, int length, void *first, int stride,
+                  void *cl);
+    void *cl;
+};
+
+/********** span_tile ********
+ *
+ * Hands each row of one tile to the client's span function
+ ************************/
+static void span_tile(int col, int row, int width, int height, void *base,
+                      int stride, void *vcl)
+{
+    struct span_closure *scl = vcl;
+    char *first = base;
+    for (int i = 0; i < height; i++, first += stride) {
+        scl->apply(col, row + i, width, first, scl->size, scl->cl);
+    }
+}
+
+/********** UArray2h_map_spans ********
+ *
+ * Visits every row of every tile of 'uarray2h' in storage order
+ *
+ * Parameters:
+ *      UArray2h_T uarray2h: array whose cells are visited
+ *      void apply(...):     called with the (col, row) of a tile row's
+ *                           first cell, the number of cells in the row,
+ *                           a pointer to the first cell, the byte stride
+ *                           between cells, and 'cl'
+ *      void *cl:            closure pointer passed through to 'apply'
+ *
+ * Expects
+ *      'uarray2h' must be a valid, non-NULL input
+ *      'apply' must be a non-NULL function pointer 
+ ************************/
+void UArray2h_map_spans(UArray2h_T uarray2h,
+                        void apply(int col, int row, int length,
+                                   void *first, int stride, void *cl),
+                        void *cl)
+{
+    assert(uarray2h != NULL && apply != NULL);
+    struct span_closure scl = { uarray2h->size, apply, cl };
+    UArray2h_map_tiles(uarray2h, span_tile, &scl);
+}
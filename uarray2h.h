@@ -0,0 +1,71 @@
+#ifndef UARRAY2H_INCLUDED
+#define UARRAY2H_INCLUDED
+
+#define T UArray2h_T
+typedef struct T *T;
+
+/* new two-level blocked 2d array: the array is cut into square blocks of
+ * 'blocksize' cells per side, and each block into square tiles of
+ * 'tilesize' cells per side; every tile is contiguous and the tiles of a
+ * block are contiguous.  Both sizes must be powers of two, with
+ * tilesize <= blocksize (checked runtime errors otherwise)
+ */
+extern T     UArray2h_new(int width, int height, int size,
+                          int blocksize, int tilesize);
+
+/* new two-level blocked 2d array: blocks are the largest power of two
+ * that fits in 64KB and tiles the largest power of two that lets a
+ * source and destination tile share half the L1 data cache
+ */
+extern T     UArray2h_new_default(int width, int height, int size);
+
+/* the tilesize UArray2h_new_default uses for cells of 'size' bytes */
+extern int   UArray2h_default_tilesize(int size);
+
+extern void  UArray2h_free     (T *array2h);
+
+extern int   UArray2h_width    (T  array2h);
+extern int   UArray2h_height   (T  array2h);
+extern int   UArray2h_size     (T  array2h);
+extern int   UArray2h_blocksize(T  array2h);
+extern int   UArray2h_tilesize (T  array2h);
+
+/* return a pointer to the cell in the given column and row.
+ * index out of range is a checked run-time error
+ */
+extern void *UArray2h_at(T array2h, int column, int row);
+
+/* visits every cell of a tile before moving to the next tile, and every
+ * tile of a block before moving to the next block
+ */
+extern void  UArray2h_map(T array2h, 
+                          void apply(int col, int row, T array2h,
+                                     void *elem, void *cl),
+                          void *cl);
+
+/* visits every tile once, in the same order as UArray2h_map; arguments
+ * are as for UArray2b_map_blocks, with tiles in place of blocks
+ */
+extern void  UArray2h_map_tiles(T array2h,
+                                void apply(int col, int row,
+                                           int width, int height,
+                                           void *base, int stride,
+                                           void *cl),
+                                void *cl);
+
+/* visits every row of every tile once, in the same order as
+ * UArray2h_map; arguments are as for UArray2b_map_spans
+ */
+extern void  UArray2h_map_spans(T array2h,
+                                void apply(int col, int row, int length,
+                                           void *first, int stride,
+                                           void *cl),
+                                void *cl);
+
+/*
+ * it is a checked run-time error to pass a NULL T
+ * to any function in this interface 
+ */
+
+#undef T
+#endif
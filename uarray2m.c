@@ -0,0 +1,345 @@
+/**************************************************************
+ *
+ *                     uarray2m.c
+ *
+ *     Assignment: Locality
+ *     Authors:    Joey Landry & Arshiya Lall 
+ *     Date:       October 7, 2024
+ *
+ *     Contains implementation of the uarray2m.c class,
+ *     a 2D array stored in Morton (Z-order) so that cells that are
+ *     close in the plane are close in memory at every scale,
+ *     without picking a blocksize for a particular cache.
+ *
+ ***************************************************************/
+
+#include "uarray2m.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/* 
+ * UArray2m_T struct
+ * Depicts a 2-dimensional unboxed array in Z-order. 
+ * The array is cut into square tiles of 2^tile_log cells per side, laid
+ * out row-major.  Within a tile, cell (i, j) sits at the index formed by
+ * interleaving the bits of i (even positions) and j (odd positions).
+ * The tile edge follows the shorter side of the array, so padding is
+ * less than one tile edge, and no more than the shorter side, in each
+ * direction.
+ */
+struct UArray2m_T {
+    int width; /* The width (num columns) of the array */
+    int height; /* The height (num rows) of the array */
+    int size; /* Size of data stored in each element of the array */
+    int tile_log; /* log2 of the number of cells per side of a tile */
+    int tiles_wide; /* Number of tiles across one row of tiles */
+    int tiles_high; /* Number of rows of tiles */
+    char *elems; /* Page-aligned slab holding all tiles */
+};
+
+enum { MAX_TILE_LOG = 8, PAGE = 4096 };
+
+/* 
+ * spread[b] places the 8 bits of b at the even bit positions of a 16-bit
+ * value; compact[b] is the inverse for the even bits of a byte
+ */
+static unsigned short spread[256];
+static unsigned char compact[256];
+static int tables_ready = 0;
+
+/********** init_tables ********
+ *
+ * Fills in the bit interleaving tables the first time they are needed
+ ************************/
+static void init_tables(void)
+{
+    if (tables_ready) {
+        return;
+    }
+    for (unsigned b = 0; b < 256; b++) {
+        unsigned s = 0, c = 0;
+        for (int k = 0; k < 8; k++) {
+            s |= ((b >> k) & 1) << (2 * k);
+        }
+        for (int k = 0; k < 4; k++) {
+            c |= ((b >> (2 * k)) & 1) << k;
+        }
+        spread[b] = s;
+        compact[b] = c;
+    }
+    tables_ready = 1;
+}
+
+/********** morton_index ********
+ *
+ * Returns the Z-order index of (col, row) within a tile
+ *
+ * Notes:
+ *      - col and row are already reduced modulo the tile edge (< 256)
+ ************************/
+static inline size_t morton_index(int col, int row)
+{
+    return spread[col] | (unsigned)spread[row] << 1;
+}
+
+/********** morton_col ********
+ *
+ * Inverse of 'morton_index': recovers the column (even bits) of a tile
+ * offset; the row is 'morton_col(d >> 1)'
+ ************************/
+static inline int morton_col(size_t d)
+{
+    return compact[d & 0xff] | compact[(d >> 8) & 0xff] << 4;
+}
+
+/********** UArray2m_new ********
+ *
+ * Allocates and returns a new Z-ordered 2D array containing 'width' 
+ * by 'height' elements of 'size' bytes each
+ *
+ * Parameters:
+ *      int width:     the number of columns in the array
+ *      int height:    the number of rows in the array
+ *      int size:      the byte size of each element
+ *
+ * Return: A new 'UArray2m_T'
+ *
+ * Expects
+ *      width, height, and size must be greater than zero
+ * 
+ * Notes:
+ *      - Checked runtime error if width, size, or height are invalid
+ *      - the tile edge is the smallest power of two covering the
+ *        shorter side, capped at 256: a thin array gets thin padding
+ *        (a 1 x n array takes n cells, not n tiles of 256 x 256)
+ ************************/
+UArray2m_T UArray2m_new(int width, int height, int size)
+{
+    assert(width > 0);
+    assert(height > 0);
+    assert(size > 0);
+
+    init_tables();
+
+    UArray2m_T uarray2m = malloc(sizeof(struct UArray2m_T));
+    assert(uarray2m != NULL);
+
+    uarray2m->width = width;
+    uarray2m->height = height;
+    uarray2m->size = size;
+
+    int shorter = width < height ? width : height;
+    int tile_log = 0;
+    while (tile_log < MAX_TILE_LOG && (1 << tile_log) < shorter) {
+        tile_log++;
+    }
+    int tile = 1 << tile_log;
+    uarray2m->tile_log = tile_log;
+    uarray2m->tiles_wide = (width + tile - 1) / tile;
+    uarray2m->tiles_high = (height + tile - 1) / tile;
+
+    void *slab = NULL;
+    size_t total = (size_t)uarray2m->tiles_wide * uarray2m->tiles_high
+                   * tile * tile * size;
+    if (posix_memalign(&slab, PAGE, total) != 0) {
+        slab = NULL;
+    }
+    assert(slab != NULL);
+    uarray2m->elems = slab;
+
+    return uarray2m;
+}
+
+/********** UArray2m_free ********
+ *
+ * Frees the tile slab and the 'UArray2m_T' struct itself
+ *
+ * Parameters:
+ *      UArray2m_T *array2m: pointer to array that needs to be freed;
+ *                           pointer is set to 'NULL' once memory is free
+ *
+ * Expects
+ *      'array2m' is a valid pointer to a non-NULL 'UArray2m_T'
+ ************************/
+void UArray2m_free(UArray2m_T *array2m)
+{
+    assert(array2m != NULL && *array2m != NULL);
+    free((*array2m)->elems);
+    free(*array2m);
+    *array2m = NULL;
+}
+
+/********** UArray2m_width ********
+ *
+ * Returns width, or number of columns, of 'array2m'
+ ************************/
+int UArray2m_width(UArray2m_T array2m)
+{
+    assert(array2m != NULL);
+    return array2m->width;
+}
+
+/********** UArray2m_height ********
+ *
+ * Returns height, or number of rows, of 'array2m'
+ ************************/
+int UArray2m_height(UArray2m_T array2m)
+{
+    assert(array2m != NULL);
+    return array2m->height;
+}
+
+/********** UArray2m_size ********
+ *
+ * Returns size (in bytes) of each element of 'array2m'
+ ************************/
+int UArray2m_size(UArray2m_T array2m)
+{
+    assert(array2m != NULL);
+    return array2m->size;
+}
+
+/********** UArray2m_tilesize ********
+ *
+ * Returns the number of cells along each side of a Z-ordered tile
+ ************************/
+int UArray2m_tilesize(UArray2m_T array2m)
+{
+    assert(array2m != NULL);
+    return 1 << array2m->tile_log;
+}
+
+/********** UArray2m_at ********
+ *
+ * Returns pointer to element at specific column and row of 'uarray2m'
+ *
+ * Parameters:
+ *      UArray2m_T uarray2m: Z-ordered 2D array where an element is accessed
+ *      int col:             column index of element (0 <= col < width)
+ *      int row:             row index of element (0 <= row < height)
+ *
+ * Return: void pointer to element at (col, row)
+ *
+ * Expects
+ *      - 'uarray2m' must be a valid, non-NULL input
+ *      - col and row are within bounds of the array
+ * 
+ * Notes:
+ *      - checked runtime error if any expectation is violated
+ *      - two table lookups and shifts; no division
+ ************************/
+void *UArray2m_at(UArray2m_T uarray2m, int col, int row)
+{
+    assert(uarray2m != NULL);
+    assert(col >= 0 && col < uarray2m->width);
+    assert(row >= 0 && row < uarray2m->height);
+
+    int lg = uarray2m->tile_log;
+    int mask = (1 << lg) - 1;
+
+    size_t tile = (size_t)(row >> lg) * uarray2m->tiles_wide + (col >> lg);
+    size_t index = (tile << (2 * lg)) | morton_index(col & mask, row & mask);
+
+    return uarray2m->elems + index * uarray2m->size;
+}
+
+/********** UArray2m_map ********
+ *
+ * Iterates through each element of 'uarray2m' in memory order (tile by
+ * tile, Z-order within a tile) and applies 'apply' to each element 
+ *
+ * Parameters:
+ *      UArray2m_T uarray2m: Z-ordered 2D array whose elements are visited
+ *      void apply(...):     function applied to every element, given the
+ *                           element's col and row, the array, a pointer
+ *                           to the element, and 'cl'
+ *      void *cl:            closure pointer passed through to 'apply'
+ *
+ * Expects
+ *      'uarray2m' must be a valid, non-NULL input
+ *      'apply' must be a non-NULL function pointer 
+ * 
+ * Notes:
+ *      - padding cells past the right and bottom edges are skipped
+ *      
+ ************************/
+void UArray2m_map(UArray2m_T uarray2m,
+                  void apply(int col, int row, UArray2m_T uarray2m, 
+                  void *elem, void *cl), void *cl)
+{
+    assert(uarray2m != NULL && apply != NULL);
+
+    int lg = uarray2m->tile_log;
+    int tile = 1 << lg;
+    size_t tile_cells = (size_t)tile * tile;
+    int size = uarray2m->size;
+    char *elem = uarray2m->elems;
+
+    for (int ty = 0; ty < uarray2m->tiles_high; ty++) {
+        int row0 = ty * tile;
+        for (int tx = 0; tx < uarray2m->tiles_wide; tx++) {
+            int col0 = tx * tile;
+            int interior = col0 + tile <= uarray2m->width &&
+                           row0 + tile <= uarray2m->height;
+            for (size_t d = 0; d < tile_cells; d++, elem += size) {
+                int col = col0 + morton_col(d);
+                int row = row0 + morton_col(d >> 1);
+                if (interior || (col < uarray2m->width &&
+                                 row < uarray2m->height)) {
+                    apply(col, row, uarray2m, elem, cl);
+                }
+            }
+        }
+    }
+}
+
+/********** UArray2m_map_spans ********
+ *
+ * Visits every cell of 'uarray2m' in memory order, two horizontally
+ * adjacent cells at a time (the longest horizontal run Z-order keeps
+ * contiguous)
+ *
+ * Parameters:
+ *      UArray2m_T uarray2m: Z-ordered 2D array whose cells are visited
+ *      void apply(...):     called with the (col, row) of the first cell,
+ *                           the run length (1 at an odd right edge, else
+ *                           2), a pointer to the first cell, the byte
+ *                           stride between cells, and 'cl'
+ *      void *cl:            closure pointer passed through to 'apply'
+ *
+ * Expects
+ *      'uarray2m' must be a valid, non-NULL input
+ *      'apply' must be a non-NULL function pointer 
+ ************************/
+void UArray2m_map_spans(UArray2m_T uarray2m,
+                        void apply(int col, int row, int length,
+                                   void *first, int stride, void *cl),
+                        void *cl)
+{
+    assert(uarray2m != NULL && apply != NULL);
+
+    int lg = uarray2m->tile_log;
+    int tile = 1 << lg;
+    size_t tile_cells = (size_t)tile * tile;
+    int size = uarray2m->size;
+    char *first = uarray2m->elems;
+
+    for (int ty = 0; ty < uarray2m->tiles_high; ty++) {
+        int row0 = ty * tile;
+        for (int tx = 0; tx < uarray2m->tiles_wide; tx++) {
+            int col0 = tx * tile;
+            /* a 1 x 1 tile holds a single cell, not a pair */
+            int step = tile_cells > 1 ? 2 : 1;
+            for (size_t d = 0; d < tile_cells; d += step,
+                                                first += step * size) {
+                int col = col0 + morton_col(d);
+                int row = row0 + morton_col(d >> 1);
+                if (col >= uarray2m->width || row >= uarray2m->height) {
+                    continue;
+                }
+                int length = col + 1 < uarray2m->width ? step : 1;
+                apply(col, row, length, first, size, cl);
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef UARRAY2M_INCLUDED
+#define UARRAY2M_INCLUDED
+
+#define T UArray2m_T
+typedef struct T *T;
+
+/* new 2d array stored in Morton (Z-order): the array is cut into square
+ * power-of-two tiles laid out row-major, and the cells of each tile are
+ * stored in Z-order.  Tiles are at most 256 x 256 cells, and no wider
+ * than the power of two covering the shorter side of the array, so a
+ * 1 x n array takes n cells.
+ * width, height, or size < 1 is a checked runtime error
+ */
+extern T     UArray2m_new      (int width, int height, int size);
+
+extern void  UArray2m_free     (T *array2m);
+
+extern int   UArray2m_width    (T  array2m);
+extern int   UArray2m_height   (T  array2m);
+extern int   UArray2m_size     (T  array2m);
+
+/* number of cells along each side of a Z-ordered tile */
+extern int   UArray2m_tilesize (T  array2m);
+
+/* return a pointer to the cell in the given column and row.
+ * index out of range is a checked run-time error
+ */
+extern void *UArray2m_at(T array2m, int column, int row);
+
+/* visits every cell in the order it is stored in memory */
+extern void  UArray2m_map(T array2m, 
+                          void apply(int col, int row, T array2m,
+                                     void *elem, void *cl),
+                          void *cl);
+
+/* visits every cell once, in memory order, as horizontal runs of
+ * adjacent cells that are also adjacent in memory; in Z-order those
+ * runs are pairs (columns 2k and 2k + 1 of one row).  Arguments are as
+ * for UArray2b_map_spans
+ */
+extern void  UArray2m_map_spans(T array2m,
+                                void apply(int col, int row, int length,
+                                           void *first, int stride,
+                                           void *cl),
+                                void *cl);
+
+/*
+ * it is a checked run-time error to pass a NULL T
+ * to any function in this interface 
+ */
+
+#undef T
+#endif